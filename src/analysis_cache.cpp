@@ -0,0 +1,336 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "analysis_cache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+#include "analyzer.hpp"
+#include "linear_executable.hpp"
+#include "little_endian.hpp"
+#include "mapped_file.hpp"
+#include "symbol_map.hpp"
+
+#if defined(WINDOWS_BUILD)
+#include <windows.h>
+#elif defined(UNIX_BUILD)
+#include <unistd.h>
+#endif
+
+static const char kCacheMagic[4] = {'L', 'E', 'D', 'C'};
+
+AnalysisCache::AnalysisCache(const std::string& directory, const MappedFile& executable, const std::string& map_file,
+                             bool scan_prologues) {
+    static const char kScanPrologues[] = "scan-prologues";
+
+    m_executable_key = Hash(executable.Data(), executable.Size(), FORMAT_VERSION);
+    /* Analysis options that change the results take part in every key. */
+    if (scan_prologues) {
+        m_executable_key = Hash((const uint8_t*)kScanPrologues, sizeof(kScanPrologues) - 1, m_executable_key);
+    }
+    m_key = m_executable_key;
+    if (!map_file.empty()) {
+        MappedFile map(map_file);
+        m_key = Hash(map.Data(), map.Size(), m_key);
+    }
+
+    m_path = GetFilePath(directory, m_key, ".cache");
+    m_previous_path = GetFilePath(directory, m_executable_key, ".latest");
+}
+
+std::string AnalysisCache::GetFilePath(const std::string& directory, uint64_t key, const char* extension) {
+    std::ostringstream path;
+    path << directory;
+    if (!directory.empty() && directory[directory.size() - 1] != '/' && directory[directory.size() - 1] != '\\') {
+        path << '/';
+    }
+    path << std::hex << std::setfill('0') << std::setw(16) << key << extension;
+    return path.str();
+}
+
+const std::string& AnalysisCache::GetPath() const { return m_path; }
+
+/* 64 bit multiply-rotate hash over little endian words, it only has to tell different inputs apart. */
+uint64_t AnalysisCache::Hash(const uint8_t* data, size_t size, uint64_t seed) {
+    const uint64_t prime = 0x9e3779b97f4a7c15ULL;
+    uint64_t hash = seed ^ (size * prime);
+    size_t n = 0;
+    for (; n + sizeof(uint64_t) <= size; n += sizeof(uint64_t)) {
+        hash = (hash ^ ReadLe<uint64_t>(data + n)) * prime;
+        hash = (hash << 31) | (hash >> 33);
+    }
+    for (; n < size; ++n) {
+        hash = (hash ^ data[n]) * prime;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+void AnalysisCache::WriteVarint(std::vector<uint8_t>& buffer, uint32_t value) {
+    while (value >= 0x80) {
+        buffer.push_back((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    buffer.push_back(value);
+}
+
+uint32_t AnalysisCache::ReadVarint(ByteCursor& cursor) {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        uint8_t byte = cursor.Read<uint8_t>();
+        value |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw Error() << "Invalid varint in analysis cache";
+}
+
+bool AnalysisCache::Load(Analyzer& analyzer, LinearExecutable& lx) {
+    if (!Load(m_path, m_key, analyzer, lx, NULL, NULL)) {
+        return false;
+    }
+    std::cerr << "Loaded analysis from cache " << m_path << std::endl;
+    return true;
+}
+
+/* Restores the state of the previous run of the same executable if the map file only gained entries since, the
+ * addresses of the new entries are returned in added. Removed or modified entries may have split regions that cannot
+ * be merged back, those require a full analysis.
+ */
+bool AnalysisCache::LoadPrevious(Analyzer& analyzer, LinearExecutable& lx, SymbolMap* map,
+                                 std::vector<uint32_t>& added) {
+    if (!map || !Load(m_previous_path, m_executable_key, analyzer, lx, map, &added)) {
+        return false;
+    }
+    std::cerr << "Loaded previous analysis from cache " << m_previous_path << std::endl;
+    return true;
+}
+
+bool AnalysisCache::Load(const std::string& path, uint64_t key, Analyzer& analyzer, LinearExecutable& lx,
+                         SymbolMap* map, std::vector<uint32_t>* added) {
+    std::ifstream is(path.c_str(), std::ios::binary);
+    if (!is.is_open()) {
+        return false;
+    }
+    std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    if (buffer.size() < sizeof(kCacheMagic) + sizeof(uint32_t) + sizeof(uint64_t) ||
+        memcmp(&buffer.front(), kCacheMagic, sizeof(kCacheMagic)) != 0) {
+        std::cerr << "Ignoring invalid analysis cache " << path << std::endl;
+        return false;
+    }
+
+    try {
+        ByteCursor cursor(&buffer.front(), buffer.size(), sizeof(kCacheMagic));
+        if (cursor.Read<uint32_t>() != FORMAT_VERSION || cursor.Read<uint64_t>() != key) {
+            return false;
+        }
+        switch (Read(cursor, analyzer, lx, map, added)) {
+            case READ_OK:
+                return true;
+            case READ_STALE:
+                std::cerr << "Map file entries were removed or changed, running full analysis" << std::endl;
+                return false;
+            case READ_INVALID:
+                std::cerr << "Ignoring invalid analysis cache " << path << std::endl;
+                return false;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Ignoring invalid analysis cache " << path << ": " << e.what() << std::endl;
+    }
+    return false;
+}
+
+/* Map file entries, regions and labels are delta encoded by address. Every region has to lie within one of the
+ * initial object regions, the analyzer is only modified once the whole cache has been validated.
+ */
+AnalysisCache::ReadResult AnalysisCache::Read(ByteCursor& cursor, Analyzer& analyzer, LinearExecutable& lx,
+                                              SymbolMap* map, std::vector<uint32_t>* added) {
+    RegionMap regions;
+    std::map<uint32_t, Type> label_types;
+    std::vector<uint32_t> removed_fixup_addresses;
+    std::map<uint32_t, SymbolMapProperties> previous_map;
+    uint32_t address = 0;
+
+    for (uint32_t count = ReadVarint(cursor); count > 0; --count) {
+        address += ReadVarint(cursor);
+        uint32_t size = ReadVarint(cursor);
+        uint8_t type = cursor.Read<uint8_t>();
+        if (type > FUNC_GUESS) {
+            return READ_INVALID;
+        }
+        previous_map[address] = SymbolMapProperties(address, size, "", (Type)type);
+    }
+
+    address = 0;
+    for (uint32_t count = ReadVarint(cursor); count > 0; --count) {
+        address += ReadVarint(cursor);
+        uint32_t size = ReadVarint(cursor);
+        uint8_t type = cursor.Read<uint8_t>();
+        Region* parent = analyzer.regions.RegionContaining(address);
+        if (!parent || type > FUNC_GUESS || (size && !parent->ContainsAddress(address + size - 1))) {
+            return READ_INVALID;
+        }
+        regions[address] = Region(address, size, (Type)type, parent->ImageObjectPointer());
+    }
+
+    address = 0;
+    for (uint32_t count = ReadVarint(cursor); count > 0; --count) {
+        address += ReadVarint(cursor);
+        uint8_t type = cursor.Read<uint8_t>();
+        if (type > FUNC_GUESS) {
+            return READ_INVALID;
+        }
+        label_types[address] = (Type)type;
+    }
+
+    address = 0;
+    for (uint32_t count = ReadVarint(cursor); count > 0; --count) {
+        address += ReadVarint(cursor);
+        removed_fixup_addresses.push_back(address);
+    }
+
+    if (cursor.Remaining() != 0) {
+        return READ_INVALID;
+    }
+
+    if (added) {
+        added->clear();
+        for (std::map<uint32_t, SymbolMapProperties>::const_iterator itr = previous_map.begin();
+             itr != previous_map.end(); ++itr) {
+            std::map<uint32_t, SymbolMapProperties>::const_iterator item = map->map.find(itr->first);
+            if (item == map->map.end() || item->second.size != itr->second.size ||
+                item->second.type != itr->second.type) {
+                return READ_STALE;
+            }
+        }
+        for (std::map<uint32_t, SymbolMapProperties>::const_iterator itr = map->map.begin(); itr != map->map.end();
+             ++itr) {
+            if (previous_map.find(itr->first) == previous_map.end()) {
+                added->push_back(itr->first);
+            }
+        }
+    }
+
+    analyzer.regions.regions.swap(regions);
+    analyzer.regions.label_types.Clear();
+    for (std::map<uint32_t, Type>::const_iterator itr = label_types.begin(); itr != label_types.end(); ++itr) {
+        analyzer.regions.label_types.Set(itr->first, itr->second);
+    }
+    lx.fixup_addresses.Erase(removed_fixup_addresses);
+    analyzer.removed_fixup_addresses.swap(removed_fixup_addresses);
+    return READ_OK;
+}
+
+/* The same state is stored under the full key and as the latest state of the executable, the two only differ in the
+ * key of their header.
+ */
+bool AnalysisCache::Save(const Analyzer& analyzer, SymbolMap* map) {
+    std::vector<uint8_t> buffer(kCacheMagic, kCacheMagic + sizeof(kCacheMagic));
+    uint8_t header[sizeof(uint32_t) + sizeof(uint64_t)];
+    WriteLe<uint32_t>(header, FORMAT_VERSION);
+    WriteLe<uint64_t>(header + sizeof(uint32_t), m_key);
+    buffer.insert(buffer.end(), header, header + sizeof(header));
+
+    uint32_t address = 0;
+    WriteVarint(buffer, map ? map->map.size() : 0);
+    if (map) {
+        for (std::map<uint32_t, SymbolMapProperties>::const_iterator itr = map->map.begin(); itr != map->map.end();
+             ++itr) {
+            WriteVarint(buffer, itr->first - address);
+            WriteVarint(buffer, itr->second.size);
+            buffer.push_back(itr->second.type);
+            address = itr->first;
+        }
+    }
+
+    address = 0;
+    WriteVarint(buffer, analyzer.regions.regions.size());
+    for (RegionMap::const_iterator itr = analyzer.regions.regions.begin();
+         itr != analyzer.regions.regions.end(); ++itr) {
+        WriteVarint(buffer, itr->first - address);
+        WriteVarint(buffer, itr->second.Size());
+        buffer.push_back(itr->second.GetType());
+        address = itr->first;
+    }
+
+    address = 0;
+    WriteVarint(buffer, analyzer.regions.label_types.Size());
+    for (LabelMap::const_iterator itr = analyzer.regions.label_types.begin();
+         itr != analyzer.regions.label_types.end(); ++itr) {
+        WriteVarint(buffer, itr->first - address);
+        buffer.push_back(itr->second);
+        address = itr->first;
+    }
+
+    std::vector<uint32_t> removed(analyzer.removed_fixup_addresses);
+    std::sort(removed.begin(), removed.end());
+    removed.erase(std::unique(removed.begin(), removed.end()), removed.end());
+    address = 0;
+    WriteVarint(buffer, removed.size());
+    for (size_t n = 0; n < removed.size(); ++n) {
+        WriteVarint(buffer, removed[n] - address);
+        address = removed[n];
+    }
+
+    if (!Write(m_path, buffer)) {
+        return false;
+    }
+    WriteLe<uint64_t>(&buffer.front() + sizeof(kCacheMagic) + sizeof(uint32_t), m_executable_key);
+    return Write(m_previous_path, buffer);
+}
+
+/* Name of a temporary file next to path that no other process, nor another thread of this one, writes to. */
+static std::string TemporaryPath(const std::string& path) {
+    static std::atomic<unsigned> counter(0);
+    std::ostringstream oss;
+    oss << path << ".tmp.";
+#if defined(WINDOWS_BUILD)
+    oss << GetCurrentProcessId();
+#elif defined(UNIX_BUILD)
+    oss << getpid();
+#endif
+    oss << '.' << counter++;
+    return oss.str();
+}
+
+/* Write to a temporary file first so that concurrent or interrupted runs never leave a partial cache behind. */
+bool AnalysisCache::Write(const std::string& path, const std::vector<uint8_t>& buffer) {
+    std::string temp_path = TemporaryPath(path);
+    {
+        std::ofstream os(temp_path.c_str(), std::ios::binary | std::ios::trunc);
+        if (!os.is_open() || !os.write((const char*)&buffer.front(), buffer.size())) {
+            std::cerr << "Warning: Unable to write analysis cache " << temp_path << std::endl;
+            return false;
+        }
+    }
+    std::remove(path.c_str());
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "Warning: Unable to write analysis cache " << path << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LE_DISASM_ANALYSIS_CACHE_HPP_
+#define LE_DISASM_ANALYSIS_CACHE_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Analyzer;
+class ByteCursor;
+class LinearExecutable;
+class MappedFile;
+class SymbolMap;
+
+/* On-disk cache of the final analysis results. Entries are keyed by a hash of the executable and the map file, a warm
+ * run restores the regions and labels instead of tracing the executable again. The most recent state of every
+ * executable is kept as well, so that entries added to the map file can be applied to it incrementally.
+ */
+class AnalysisCache {
+public:
+    AnalysisCache(const std::string& directory, const MappedFile& executable, const std::string& map_file,
+                  bool scan_prologues = false);
+
+    bool Load(Analyzer& analyzer, LinearExecutable& lx);
+    bool LoadPrevious(Analyzer& analyzer, LinearExecutable& lx, SymbolMap* map, std::vector<uint32_t>& added);
+    bool Save(const Analyzer& analyzer, SymbolMap* map);
+    const std::string& GetPath() const;
+
+    static uint64_t Hash(const uint8_t* data, size_t size, uint64_t seed);
+
+private:
+    enum { FORMAT_VERSION = 2 };
+    enum ReadResult { READ_OK, READ_INVALID, READ_STALE };
+
+    std::string m_path;
+    std::string m_previous_path;
+    uint64_t m_key;
+    uint64_t m_executable_key;
+
+    bool Load(const std::string& path, uint64_t key, Analyzer& analyzer, LinearExecutable& lx, SymbolMap* map,
+              std::vector<uint32_t>* added);
+    ReadResult Read(ByteCursor& cursor, Analyzer& analyzer, LinearExecutable& lx, SymbolMap* map,
+                    std::vector<uint32_t>* added);
+    bool Write(const std::string& path, const std::vector<uint8_t>& buffer);
+    static std::string GetFilePath(const std::string& directory, uint64_t key, const char* extension);
+    static void WriteVarint(std::vector<uint8_t>& buffer, uint32_t value);
+    static uint32_t ReadVarint(ByteCursor& cursor);
+};
+
+#endif
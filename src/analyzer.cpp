@@ -30,10 +30,19 @@
 #include "little_endian.hpp"
 #include "print.hpp"
 #include "symbol_map.hpp"
+#include "x86_decoder.hpp"
 
 Analyzer::Analyzer(LinearExecutable& lx, Image& image_, bool verbose_)
-    : regions(image_.objects, verbose_), image(image_) {
+    : regions(image_, verbose_),
+      image(image_),
+      m_verified_count(0),
+      m_native_count(0),
+      m_mismatch_count(0),
+      m_pre_decoder(image_) {
     verbose = verbose_;
+    verify_decoder = false;
+    scan_prologues = false;
+    jobs = 1;
 }
 
 void Analyzer::AddCodeTraceAddress(uint32_t address, Type type, uint32_t refAddress) {
@@ -42,12 +51,40 @@ void Analyzer::AddCodeTraceAddress(uint32_t address, Type type, uint32_t refAddr
     else
         this->code_trace_queue.push_back(address);
 
-    regions.label_types[address] = type;
+    regions.label_types.Set(address, type);
     if (refAddress > 0) {
         if (verbose) PrintAddress(PrintAddress(std::cerr, refAddress) << " schedules ", address) << std::endl;
     }
 }
 
+/* Starts decoding the code reachable from the entry point, the map file entries and the relocation targets on the
+ * threads left next to the tracer. The tracer picks up what they decoded, the regions and labels are still built
+ * serially.
+ */
+void Analyzer::StartPreDecoding(LinearExecutable& lx, SymbolMap* map) {
+    std::vector<uint32_t> seeds(1, lx.EntryPointAddress());
+
+    if (map) {
+        for (std::map<uint32_t, SymbolMapProperties>::iterator it = map->map.begin(); it != map->map.end(); ++it) {
+            seeds.push_back(it->second.address);
+        }
+    }
+    for (size_t n = 0; n < image.objects.size(); ++n) {
+        for (size_t i = 0; i < lx.fixups[n].Size(); ++i) {
+            seeds.push_back(lx.fixups[n].Address(i));
+        }
+    }
+
+    m_pre_decoder.Start(seeds, jobs - 1);
+}
+
+void Analyzer::StopPreDecoding() {
+    size_t count = m_pre_decoder.Stop();
+    if (verbose) {
+        std::cerr << std::dec << count << " instruction(s) decoded ahead on " << jobs - 1 << " thread(s)" << std::endl;
+    }
+}
+
 void Analyzer::TraceCode() {
     uint32_t address;
 
@@ -65,21 +102,22 @@ void Analyzer::TraceCodeAtAddress(uint32_t start_addr) {
         return;
     }
 
-    const ImageObject& obj = image.ObjectAt(start_addr);
+    const ImageObject& obj = *reg->ImageObjectPointer();
     if (reg->GetType() == CODE || reg->GetType() == DATA) {
         if (reg->GetType() == CODE) {
-            std::map<uint32_t, Type>::iterator label = regions.label_types.find(start_addr);
-            if (regions.label_types.end() != label && label->second == FUNC_GUESS) {
+            Type label;
+            if (regions.label_types.Get(start_addr, &label) && label == FUNC_GUESS) {
                 Insn inst(std::addressof(obj));
                 disasm.Disassemble(start_addr, obj.GetDataAt(start_addr), reg->EndAddress() - start_addr, inst);
-                label->second = (strstr(inst.text, "push") == inst.text ||
-                                 (strstr(inst.text, "sub") == inst.text && strstr(inst.text, ",%esp") != NULL))
-                                    ? FUNCTION
-                                    : JUMP;
+                label = (strstr(inst.text, "push") == inst.text ||
+                         (strstr(inst.text, "sub") == inst.text && strstr(inst.text, ",%esp") != NULL))
+                            ? FUNCTION
+                            : JUMP;
+                regions.label_types.Set(start_addr, label);
             }
         }
         return;
-    } else if (regions.label_types.end() == regions.label_types.find(start_addr)) {
+    } else if (!regions.label_types.Contains(start_addr)) {
         PrintAddress(std::cerr, start_addr, "Warning: Tracing code without label: 0x") << std::endl;
     } else if (reg->GetType() == SWITCH) {
         return;
@@ -92,9 +130,8 @@ void Analyzer::TraceCodeAtAddress(uint32_t start_addr) {
         type = DATA;
     }
     if (DATA == type) {
-        std::map<uint32_t, Type>::iterator label = regions.label_types.find(start_addr);
-        if (regions.label_types.end() != label) {
-            label->second = DATA;
+        if (regions.label_types.Contains(start_addr)) {
+            regions.label_types.Set(start_addr, DATA);
         }
     }
     regions.SplitInsert(*reg, Region(start_addr, addr - start_addr, type));
@@ -109,25 +146,20 @@ size_t Analyzer::TraceRegionUntilAnyJump(Region*& tracedReg, uint32_t& startAddr
             return addr;
         }
         if (DATA != type) {
-            char invalids[][6] = {"(bad)", "ss", "gs"};
-            for (size_t i = 0; i < sizeof(invalids) / sizeof(invalids[0]); ++i) {
-                if (strstr(inst.text, invalids[i]) == inst.text) {
-                    type = DATA;
-                    break;
-                }
+            if (inst.flags & Insn::INVALID) {
+                type = DATA;
             }
-            if (strstr(inst.text, "nop") == inst.text) {
+            if (inst.flags & Insn::NOP) {
                 ++nopCount;
 
-            } else if (DATA != type && *inst.text == 'f' && inst.memory_address > 0 &&
-                       strncmp(inst.text, "fs ", strlen("fs ")) != 0) {
+            } else if (DATA != type && (inst.flags & Insn::FPU) && inst.memory_address > 0) {
                 Region* reg = regions.RegionContaining(inst.memory_address);
                 if (reg == NULL) {
                     continue;
                 } else if (reg->GetType() == UNKNOWN) {
-                    if (strstr(inst.text, "t ") != NULL) {
+                    if (inst.flags & Insn::FPU_M80) {
                         regions.SplitInsert(*reg, Region(inst.memory_address, 10, DATA));
-                    } else if (strstr(inst.text, "l ") != NULL) {
+                    } else if (inst.flags & Insn::FPU_M64) {
                         regions.SplitInsert(*reg, Region(inst.memory_address, 8, DATA));
                     } else {
                         throw Error() << "0x" << std::hex << addr - inst.size << ": unsupported FPU operand size in "
@@ -139,24 +171,25 @@ size_t Analyzer::TraceRegionUntilAnyJump(Region*& tracedReg, uint32_t& startAddr
                 } else if (reg->GetType() != DATA) {
                     PrintAddress(std::cerr, inst.memory_address, "Warning: 0x") << " marked as data" << std::endl;
                 }
-                regions.label_types[inst.memory_address] = DATA;
-            } else if (addr - inst.size == startAddress && strstr(inst.text, "mov    $") == inst.text) {
-                uint32_t dataAddress = strtol(&inst.text[strlen("mov    $")], NULL, 16);
-                if (regions.RegionContaining(dataAddress) != NULL) {
-                    const ImageObject& obj = image.ObjectAt(dataAddress);
+                regions.label_types.Set(inst.memory_address, DATA);
+            } else if (addr - inst.size == startAddress && (inst.flags & Insn::MOV_IMMEDIATE)) {
+                uint32_t dataAddress = inst.immediate;
+                Region* dataReg = regions.RegionContaining(dataAddress);
+                if (dataReg != NULL) {
+                    const ImageObject& obj = *dataReg->ImageObjectPointer();
                     if (strncmp("ABNORMAL TERMINATION", (const char*)(obj.GetDataAt(dataAddress)),
                                 strlen("ABNORMAL TERMINATION")) == 0) {
                         PrintAddress(PrintAddress(std::cerr, startAddress) << ": ___abort signature found at ",
                                      dataAddress)
                             << std::endl;
-                        regions.label_types[startAddress] = FUNCTION;
+                        regions.label_types.Set(startAddress, FUNCTION);
                     }
                 }
             } else if (inst.GetBitness() == BITNESS_16BIT and inst.memory_address > 0) {
                 uint32_t virtual_address = inst.BaseAddress() + inst.memory_address;
                 Region* reg = regions.RegionContaining(virtual_address);
                 if (reg and reg->GetType() == DATA) {
-                    regions.label_types[virtual_address] = DATA;
+                    regions.label_types.Set(virtual_address, DATA);
                 }
             }
         }
@@ -166,20 +199,60 @@ size_t Analyzer::TraceRegionUntilAnyJump(Region*& tracedReg, uint32_t& startAddr
 
 void Analyzer::Disassemble(uint32_t addr, Region*& tracedReg, Insn& inst, const void* data_ptr, Type type) {
     uint32_t end_addr = tracedReg->EndAddress();
-    for (disasm.Disassemble(addr, data_ptr, end_addr - addr, inst); inst.memory_address == 0 || DATA == type;) {
+    for (Decode(addr, data_ptr, end_addr - addr, inst); inst.memory_address == 0 || DATA == type;) {
         return;
     }
-    if ((Insn::COND_JUMP == inst.type || Insn::JUMP == inst.type) && strstr(inst.text, "*") == NULL) {
+    if ((Insn::COND_JUMP == inst.type || Insn::JUMP == inst.type) && !(inst.flags & Insn::INDIRECT)) {
         AddCodeTraceAddress(inst.memory_address, JUMP, addr);
     } else if (Insn::CALL == inst.type) {
         AddCodeTraceAddress(inst.memory_address, FUNCTION, addr);
     }
 }
 
-size_t Analyzer::AddSwitchAddresses(std::map<uint32_t, uint32_t>& fixups, size_t size, const ImageObject& obj,
-                                    uint32_t address) {
+/* Tracing uses the instructions decoded ahead or the native decoder and falls back to libopcodes for encodings it does
+ * not support. When verifying, the libopcodes result is traced and the native decoder is only checked against it.
+ */
+void Analyzer::Decode(uint32_t addr, const void* data, size_t length, Insn& inst) {
+    if (verify_decoder) {
+        disasm.Disassemble(addr, data, length, inst);
+        VerifyDecoder(addr, data, length, inst);
+    } else if (!m_pre_decoder.Lookup(addr, length, inst) && !X86Decoder::Decode(addr, data, length, inst)) {
+        disasm.Disassemble(addr, data, length, inst);
+    }
+}
+
+void Analyzer::VerifyDecoder(uint32_t addr, const void* data, size_t length, const Insn& expected) {
+    const unsigned compared_flags =
+        Insn::INVALID | Insn::NOP | Insn::FPU | Insn::MOV_IMMEDIATE | Insn::FPU_M80 | Insn::FPU_M64 | Insn::INDIRECT;
+    Insn native(expected.ImageObjectPointer());
+
+    ++m_verified_count;
+    if (!X86Decoder::Decode(addr, data, length, native)) {
+        return;
+    }
+    ++m_native_count;
+
+    bool same_flags = (native.flags & compared_flags) == (expected.flags & compared_flags);
+    if (native.size != expected.size || native.type != expected.type ||
+        native.memory_address != expected.memory_address || !same_flags || native.immediate != expected.immediate) {
+        ++m_mismatch_count;
+        PrintAddress(std::cerr, addr, "Decoder mismatch at 0x")
+            << ": libopcodes '" << expected.text << "' size " << std::dec << expected.size << " type "
+            << expected.type << " flags " << expected.flags << ", native size " << native.size << " type "
+            << native.type << " flags " << native.flags << std::hex << ", targets 0x" << expected.memory_address
+            << " and 0x" << native.memory_address << std::endl;
+    }
+}
+
+void Analyzer::ReportDecoderVerification() {
+    if (verify_decoder) {
+        std::cerr << "Decoder verification: " << std::dec << m_verified_count << " instruction(s), " << m_native_count
+                  << " decoded natively, " << m_mismatch_count << " mismatch(es)" << std::endl;
+    }
+}
+
+size_t Analyzer::AddSwitchAddresses(size_t size, const ImageObject& obj, uint32_t address) {
     size_t count = 0;
-    uint32_t offset = address - obj.BaseAddress();
     const uint8_t* data_ptr = obj.GetDataAt(address);
     switch (obj.GetBitness()) {
         case Bitness::BITNESS_32BIT: {
@@ -190,7 +263,7 @@ size_t Analyzer::AddSwitchAddresses(std::map<uint32_t, uint32_t>& fixups, size_t
                     break;
                 }
                 if (case_address != 0) {
-                    if (fixups.find(offset + off) == fixups.end()) {
+                    if (!obj.IsRelocation(address + off)) {
                         break;
                     }
                     if (reg->GetType() == DATA) {
@@ -209,7 +282,7 @@ size_t Analyzer::AddSwitchAddresses(std::map<uint32_t, uint32_t>& fixups, size_t
                     break;
                 }
                 if (case_address != 0) {
-                    if (fixups.find(offset + off) == fixups.end()) {
+                    if (!obj.IsRelocation(address + off)) {
                         break;
                     }
                     if (reg->GetType() == DATA) {
@@ -224,18 +297,17 @@ size_t Analyzer::AddSwitchAddresses(std::map<uint32_t, uint32_t>& fixups, size_t
     return count;
 }
 
-void Analyzer::TraceRegionSwitches(LinearExecutable& lx, std::map<uint32_t, uint32_t>& fixups, Region& reg,
-                                   uint32_t address) {
-    const ImageObject& obj = image.ObjectAt(reg.Address());
+void Analyzer::TraceRegionSwitches(LinearExecutable& lx, Region& reg, uint32_t address) {
+    const ImageObject& obj = *reg.ImageObjectPointer();
     if (!obj.IsExecutable()) {
         return;
     }
     size_t size = reg.EndAddress() - address;
-    std::set<uint32_t>::iterator iter = lx.fixup_addresses.upper_bound(address);
-    if (lx.fixup_addresses.end() != iter) {
-        size = std::min<size_t>(size, *iter - address);
+    size_t next = lx.fixup_addresses.UpperBound(address);
+    if (next < lx.fixup_addresses.Size()) {
+        size = std::min<size_t>(size, lx.fixup_addresses[next] - address);
     }
-    size_t count = AddSwitchAddresses(fixups, size, obj, address);
+    size_t count = AddSwitchAddresses(size, obj, address);
     if (count > 0) {
         if (reg.GetBitness() == Bitness::BITNESS_32BIT) {
             size = sizeof(uint32_t) * count;
@@ -243,50 +315,58 @@ void Analyzer::TraceRegionSwitches(LinearExecutable& lx, std::map<uint32_t, uint
             size = sizeof(uint16_t) * count;
         }
         regions.SplitInsert(reg, Region(address, size, SWITCH));
-        regions.label_types[address] = SWITCH;
+        regions.label_types.Set(address, SWITCH);
         TraceCode();
     }
 }
 
-void Analyzer::TraceSwitches(LinearExecutable& lx, std::map<uint32_t, uint32_t>& fixups) {
-    for (std::map<uint32_t, uint32_t>::const_iterator itr = fixups.begin(); itr != fixups.end(); ++itr) {
-        Region* reg = regions.RegionContaining(itr->second);
+void Analyzer::TraceSwitches(LinearExecutable& lx, const FixupIndex& fixups) {
+    for (size_t n = 0; n < fixups.Size(); ++n) {
+        uint32_t address = fixups.Address(n);
+        Region* reg = regions.RegionContaining(address);
         if (reg == NULL) {
-            PrintAddress(std::cerr, itr->second, "Warning: Removing reloc pointing to unmapped memory at 0x")
-                << std::endl;
-            lx.fixup_addresses.erase(itr->second);
+            PrintAddress(std::cerr, address, "Warning: Removing reloc pointing to unmapped memory at 0x") << std::endl;
+            removed_fixup_addresses.push_back(address);
             continue;
         } else if (reg->GetType() == UNKNOWN) {
-            TraceRegionSwitches(lx, fixups, *reg, itr->second);
+            TraceRegionSwitches(lx, *reg, address);
         }
     }
 }
 
+/* Relocs to unmapped memory are collected while tracing and removed from the fixup addresses at once. They lie outside
+ * of all regions, so keeping them until then does not change where the switch tables end.
+ */
 void Analyzer::TraceSwitches(LinearExecutable& lx) {
+    size_t removed = removed_fixup_addresses.size();
     for (size_t n = 0; n < lx.objects.size(); ++n) {
         TraceSwitches(lx, lx.fixups[n]);
     }
+    lx.fixup_addresses.Erase(
+        std::vector<uint32_t>(removed_fixup_addresses.begin() + removed, removed_fixup_addresses.end()));
 }
 
 void Analyzer::AddAddress(size_t& guess_count, uint32_t address) {
-    Type& type = regions.label_types[address];
+    Type type = regions.label_types.Insert(address);
     if (FUNCTION != type and JUMP != type) {
         if (verbose) PrintAddress(std::cerr, address, "Guessing that 0x") << " is a function" << std::endl;
         ++guess_count;
         type = FUNC_GUESS;
+        regions.label_types.Set(address, type);
     }
     AddCodeTraceAddress(address, type);
 }
 
-void Analyzer::AddAddressesFromUnknownRegions(size_t& guess_count, std::map<uint32_t, uint32_t>& fixups) {
-    for (std::map<uint32_t, uint32_t>::const_iterator itr = fixups.begin(); itr != fixups.end(); ++itr) {
-        Region* reg = regions.RegionContaining(itr->second);
+void Analyzer::AddAddressesFromUnknownRegions(size_t& guess_count, const FixupIndex& fixups) {
+    for (size_t n = 0; n < fixups.Size(); ++n) {
+        uint32_t address = fixups.Address(n);
+        Region* reg = regions.RegionContaining(address);
         if (reg == NULL) {
             continue;
         } else if (reg->GetType() == UNKNOWN) {
-            AddAddress(guess_count, itr->second);
+            AddAddress(guess_count, address);
         } else if (reg->GetType() == DATA) {
-            regions.label_types[itr->second] = DATA;
+            regions.label_types.Set(address, DATA);
         }
     }
 }
@@ -299,66 +379,107 @@ void Analyzer::TraceRemainingRelocs(LinearExecutable& lx) {
     if (verbose) std::cerr << std::dec << guess_count << " guess(es) to investigate" << std::endl;
 }
 
-void Analyzer::ProcessMap(SymbolMap* map, LinearExecutable& lx) {
-    for (std::map<uint32_t, SymbolMapProperties>::iterator it = map->map.begin(); it != map->map.end(); ++it) {
-        const SymbolMapProperties& item = it->second;
-        const Region* const reg = regions.RegionContaining(item.address);
+/* Returns true if data starts with a 32 bit function prologue. Watcom code saves the registers it clobbers before it
+ * sets up a frame, e.g. push %ebx; push %ecx; push %ebp; mov %esp,%ebp; sub $0x10,%esp. A run of pushes only counts
+ * if it ends in a frame setup or a stack allocation.
+ */
+static bool IsPrologue(const uint8_t* data, size_t size) {
+    size_t n = 0;
 
-        if (item.type == FUNCTION) {
-            Type label;
-            if (regions.GetLabelType(item.address, &label) && label == FUNCTION) {
-                continue;
+    while (n < size && n < 6 &&
+           (data[n] == 0x53 || data[n] == 0x51 || data[n] == 0x52 || data[n] == 0x56 || data[n] == 0x57 ||
+            data[n] == 0x55)) {
+        ++n;
+    }
+    if (n + 2 > size) {
+        return false;
+    }
+    if ((data[n] == 0x89 && data[n + 1] == 0xe5) || (data[n] == 0x8b && data[n + 1] == 0xec)) {
+        return n > 0 && data[n - 1] == 0x55;
+    }
+    if (data[n] == 0x83 && data[n + 1] == 0xec) {
+        return n + 3 <= size;
+    }
+    if (data[n] == 0x81 && data[n + 1] == 0xec) {
+        return n + 6 <= size;
+    }
+    return false;
+}
+
+/* Prologues are only accepted where a function can start: right after a return or alignment padding. */
+static bool FollowsFunctionEnd(const uint8_t* data, size_t offset) {
+    uint8_t previous = data[offset - 1];
+    if (previous == 0xc3 || previous == 0xcb || previous == 0x90 || previous == 0xcc || previous == 0x00) {
+        return true;
+    }
+    return offset >= 3 && (data[offset - 3] == 0xc2 || data[offset - 3] == 0xca);
+}
+
+/* Finds functions that are only reachable indirectly by their prologue in the unknown regions of executable objects.
+ * Every candidate is traced before the next one is looked at, candidates that turned out to be part of the code
+ * found from an earlier one are skipped.
+ */
+void Analyzer::ScanPrologues() {
+    std::vector<uint32_t> candidates;
+    size_t count = 0;
+
+    for (RegionMap::const_iterator itr = regions.regions.begin(); itr != regions.regions.end();
+         ++itr) {
+        const Region& reg = itr->second;
+        if (reg.GetType() != UNKNOWN || reg.ImageObjectPointer()->GetBitness() != BITNESS_32BIT) {
+            continue;
+        }
+
+        const uint8_t* data = reg.ImageObjectPointer()->GetDataAt(reg.Address());
+        for (size_t offset = 0; offset < reg.Size(); ++offset) {
+            if ((offset == 0 || FollowsFunctionEnd(data, offset)) && IsPrologue(&data[offset], reg.Size() - offset)) {
+                candidates.push_back(reg.Address() + offset);
             }
-            AddCodeTraceAddress(item.address, item.type);
-            if (verbose)
-                PrintAddress(std::cerr << "Map file " << map->GetFileName() << " schedules ", item.address)
-                    << std::endl;
-        } else if (item.type == SWITCH) {
-            const uint32_t address = item.address;
-            const ImageObject& obj = image.ObjectAt(item.address);
-            const uint8_t* data_ptr = obj.GetDataAt(item.address);
-            const size_t size = std::min<size_t>(item.size, reg->EndAddress() - address);
-
-            switch (reg->GetBitness()) {
-                case Bitness::BITNESS_32BIT: {
-                    size_t count = 0;
-
-                    if (size < item.size)
-                        std::cerr << "Map file object at address 0x" << std::hex << address
-                                  << " does not fit into containing region." << std::endl;
-
-                    for (size_t offset = 0; offset + sizeof(uint32_t) <= size; offset += sizeof(uint32_t), ++count) {
-                        uint32_t case_address = ReadLe<uint32_t>(data_ptr + offset);
-                        Type label;
-                        if (0 == regions.GetLabelType(case_address, &label)) {
-                            if (map->GetLabelType(case_address, &label)) {
-                                if (label != DATA) {
-                                    AddCodeTraceAddress(case_address, label);
-                                    if (verbose)
-                                        PrintAddress(std::cerr << "Map file " << map->GetFileName() << " schedules ",
-                                                     item.address)
-                                            << std::endl;
-                                }
-                            }
-                        }
-                    }
-                    regions.SplitInsert((Region&)*reg, Region(address, sizeof(uint32_t) * count, SWITCH));
-                    regions.label_types[address] = SWITCH;
-                } break;
-                case Bitness::BITNESS_16BIT: {
-                    size_t count = 0;
-
-                    if (size < item.size)
-                        std::cerr << "Warning: Map file object at address 0x" << std::hex << address
-                                  << " does not fit into containing region." << std::endl;
-
-                    for (size_t offset = 0; offset + sizeof(uint16_t) <= size; offset += sizeof(uint16_t), ++count) {
-                        uint32_t case_address = ReadLe<uint16_t>(data_ptr + offset) + obj.BaseAddress();
-                        Type label;
-                        if (regions.GetLabelType(case_address, &label)) {
-                            continue;
-                        }
+        }
+    }
+
+    for (size_t n = 0; n < candidates.size(); ++n) {
+        Region* reg = regions.RegionContaining(candidates[n]);
+        if (reg == NULL || reg->GetType() != UNKNOWN) {
+            continue;
+        }
+        if (verbose) PrintAddress(std::cerr, candidates[n], "Found a function prologue at 0x") << std::endl;
+        AddCodeTraceAddress(candidates[n], FUNCTION);
+        TraceCode();
+        ++count;
+    }
+    if (verbose) std::cerr << std::dec << count << " function(s) found by their prologue" << std::endl;
+}
 
+void Analyzer::ProcessMapItem(SymbolMap* map, LinearExecutable& lx, const SymbolMapProperties& item) {
+    const Region* const reg = regions.RegionContaining(item.address);
+
+    if (item.type == FUNCTION) {
+        Type label;
+        if (regions.GetLabelType(item.address, &label) && label == FUNCTION) {
+            return;
+        }
+        AddCodeTraceAddress(item.address, item.type);
+        if (verbose)
+            PrintAddress(std::cerr << "Map file " << map->GetFileName() << " schedules ", item.address) << std::endl;
+    } else if (item.type == SWITCH) {
+        const uint32_t address = item.address;
+        const ImageObject& obj = image.ObjectAt(item.address);
+        const uint8_t* data_ptr = obj.GetDataAt(item.address);
+        const size_t size = std::min<size_t>(item.size, reg->EndAddress() - address);
+
+        switch (reg->GetBitness()) {
+            case Bitness::BITNESS_32BIT: {
+                size_t count = 0;
+
+                if (size < item.size)
+                    std::cerr << "Map file object at address 0x" << std::hex << address
+                              << " does not fit into containing region." << std::endl;
+
+                for (size_t offset = 0; offset + sizeof(uint32_t) <= size; offset += sizeof(uint32_t), ++count) {
+                    uint32_t case_address = ReadLe<uint32_t>(data_ptr + offset);
+                    Type label;
+                    if (0 == regions.GetLabelType(case_address, &label)) {
                         if (map->GetLabelType(case_address, &label)) {
                             if (label != DATA) {
                                 AddCodeTraceAddress(case_address, label);
@@ -369,27 +490,60 @@ void Analyzer::ProcessMap(SymbolMap* map, LinearExecutable& lx) {
                             }
                         }
                     }
-                    regions.SplitInsert((Region&)*reg, Region(address, sizeof(uint16_t) * count, SWITCH));
-                    regions.label_types[address] = SWITCH;
-                } break;
-                default:
-                    break;
-            }
-        } else if (item.type == DATA) {
-            Type label;
-            if (regions.GetLabelType(item.address, &label) && label == DATA) {
-                continue;
-            }
-            const size_t size = std::min<size_t>(item.size, reg->EndAddress() - item.address);
-            if (size < item.size)
-                std::cerr << "Warning: Map file object at address 0x" << std::hex << item.address
-                          << " does not fit into containing region." << std::endl;
-            regions.SplitInsert((Region&)*reg, Region(item.address, size, DATA));
-        } else if (item.type == JUMP) {
-            if (lx.fixup_addresses.find(item.address) != lx.fixup_addresses.end()) {
-                regions.label_types[item.address] = JUMP;
-            }
+                }
+                regions.SplitInsert((Region&)*reg, Region(address, sizeof(uint32_t) * count, SWITCH));
+                regions.label_types.Set(address, SWITCH);
+            } break;
+            case Bitness::BITNESS_16BIT: {
+                size_t count = 0;
+
+                if (size < item.size)
+                    std::cerr << "Warning: Map file object at address 0x" << std::hex << address
+                              << " does not fit into containing region." << std::endl;
+
+                for (size_t offset = 0; offset + sizeof(uint16_t) <= size; offset += sizeof(uint16_t), ++count) {
+                    uint32_t case_address = ReadLe<uint16_t>(data_ptr + offset) + obj.BaseAddress();
+                    Type label;
+                    if (regions.GetLabelType(case_address, &label)) {
+                        continue;
+                    }
+
+                    if (map->GetLabelType(case_address, &label)) {
+                        if (label != DATA) {
+                            AddCodeTraceAddress(case_address, label);
+                            if (verbose)
+                                PrintAddress(std::cerr << "Map file " << map->GetFileName() << " schedules ",
+                                             item.address)
+                                    << std::endl;
+                        }
+                    }
+                }
+                regions.SplitInsert((Region&)*reg, Region(address, sizeof(uint16_t) * count, SWITCH));
+                regions.label_types.Set(address, SWITCH);
+            } break;
+            default:
+                break;
+        }
+    } else if (item.type == DATA) {
+        Type label;
+        if (regions.GetLabelType(item.address, &label) && label == DATA) {
+            return;
         }
+        const size_t size = std::min<size_t>(item.size, reg->EndAddress() - item.address);
+        if (size < item.size)
+            std::cerr << "Warning: Map file object at address 0x" << std::hex << item.address
+                      << " does not fit into containing region." << std::endl;
+        regions.SplitInsert((Region&)*reg, Region(item.address, size, DATA));
+    } else if (item.type == JUMP) {
+        if (lx.fixup_addresses.Contains(item.address)) {
+            regions.label_types.Set(item.address, JUMP);
+        }
+    }
+}
+
+void Analyzer::ProcessMap(SymbolMap* map, LinearExecutable& lx) {
+    for (std::map<uint32_t, SymbolMapProperties>::iterator it = map->map.begin(); it != map->map.end(); ++it) {
+        ProcessMapItem(map, lx, it->second);
     }
     TraceCode();
 }
@@ -429,11 +583,11 @@ bool Analyzer::IsAlignPattern(uint32_t size, const uint8_t data[]) {
 }
 
 void Analyzer::TraceAlign() {
-    for (std::map<uint32_t, Region>::iterator itr = regions.regions.begin(); itr != regions.regions.end(); ++itr) {
+    for (RegionMap::iterator itr = regions.regions.begin(); itr != regions.regions.end(); ++itr) {
         Region& reg = itr->second;
 
         if ((regions.regions.end() != itr) && (reg.GetType() == UNKNOWN)) {
-            const std::map<uint32_t, Region>::const_iterator next_itr = std::next(itr);
+            const RegionMap::const_iterator next_itr = std::next(itr);
             if (regions.regions.end() != next_itr) {
                 const Region& next_reg = next_itr->second;
                 if (next_reg.GetType() != UNKNOWN && next_reg.GetType() != ALIGNMENT) {
@@ -453,6 +607,9 @@ void Analyzer::TraceAlign() {
 
 void Analyzer::Run(LinearExecutable& lx, SymbolMap* map) {
     uint32_t eip = lx.EntryPointAddress();
+    if (jobs > 1 && !verify_decoder) {
+        StartPreDecoding(lx, map);
+    }
     AddCodeTraceAddress(eip, FUNCTION);
     if (verbose)
         PrintAddress(std::cerr, eip, "Tracing code directly accessible from the entry point at 0x") << std::endl;
@@ -466,9 +623,32 @@ void Analyzer::Run(LinearExecutable& lx, SymbolMap* map) {
     std::cerr << "Tracing text relocs for switches..." << std::endl;
     TraceSwitches(lx);
 
+    if (scan_prologues) {
+        std::cerr << "Scanning for function prologues..." << std::endl;
+        ScanPrologues();
+    }
+
     std::cerr << "Tracing remaining relocs for functions and data..." << std::endl;
     TraceRemainingRelocs(lx);
     TraceCode();
 
+    if (jobs > 1 && !verify_decoder) {
+        StopPreDecoding();
+    }
+
+    TraceAlign();
+    ReportDecoderVerification();
+}
+
+/* Applies map file entries that were added since the analysis state was restored from the cache, only code that
+ * becomes reachable through them is traced.
+ */
+void Analyzer::RunIncremental(LinearExecutable& lx, SymbolMap* map, const std::vector<uint32_t>& addresses) {
+    std::cerr << "Applying " << std::dec << addresses.size() << " new map file entries..." << std::endl;
+    for (size_t n = 0; n < addresses.size(); ++n) {
+        ProcessMapItem(map, lx, map->map[addresses[n]]);
+    }
+    TraceCode();
     TraceAlign();
+    ReportDecoderVerification();
 }
@@ -22,13 +22,17 @@
 #include <cstdint>
 #include <deque>
 #include <map>
+#include <vector>
 
 #include "dis_info.hpp"
+#include "fixup_index.hpp"
+#include "pre_decoder.hpp"
 #include "regions.hpp"
 
 class LinearExecutable;
 class Image;
 class SymbolMap;
+class SymbolMapProperties;
 class Region;
 class ImageObject;
 
@@ -38,29 +42,49 @@ class Analyzer {
 public:
     Regions regions;
     std::deque<uint32_t> code_trace_queue;
+    /* Fixup targets dropped from LinearExecutable::fixup_addresses because they point to unmapped memory. */
+    std::vector<uint32_t> removed_fixup_addresses;
     Image& image;
     DisInfo disasm;
     bool verbose;
+    /* Trace with libopcodes and report where the native decoder disagrees with it. */
+    bool verify_decoder;
+    /* Seed the trace with functions found by their prologue before relocations are guessed at. */
+    bool scan_prologues;
+    /* Threads used by the analysis, all but the tracer's own decode code ahead of it. */
+    unsigned jobs;
 
     Analyzer(LinearExecutable& lx, Image& image_, bool verbose_);
 
     void Run(LinearExecutable& lx, SymbolMap* map);
+    void RunIncremental(LinearExecutable& lx, SymbolMap* map, const std::vector<uint32_t>& addresses);
     void AddCodeTraceAddress(uint32_t address, Type type, uint32_t refAddress = 0);
 
 private:
+    size_t m_verified_count;
+    size_t m_native_count;
+    size_t m_mismatch_count;
+    PreDecoder m_pre_decoder;
+
+    void StartPreDecoding(LinearExecutable& lx, SymbolMap* map);
+    void StopPreDecoding();
     void TraceCode();
     void TraceCodeAtAddress(uint32_t start_addr);
     size_t TraceRegionUntilAnyJump(Region*& tracedReg, uint32_t& startAddress, const void* offset, Type& type,
                                    uint32_t& nopCount);
     void Disassemble(uint32_t addr, Region*& tracedReg, Insn& inst, const void* data_ptr, Type type);
-    size_t AddSwitchAddresses(std::map<uint32_t, uint32_t>& fixups, size_t size, const ImageObject& obj,
-                              uint32_t address);
-    void TraceRegionSwitches(LinearExecutable& lx, std::map<uint32_t, uint32_t>& fixups, Region& reg, uint32_t address);
-    void TraceSwitches(LinearExecutable& lx, std::map<uint32_t, uint32_t>& fixups);
+    void Decode(uint32_t addr, const void* data, size_t length, Insn& inst);
+    void VerifyDecoder(uint32_t addr, const void* data, size_t length, const Insn& expected);
+    void ReportDecoderVerification();
+    size_t AddSwitchAddresses(size_t size, const ImageObject& obj, uint32_t address);
+    void TraceRegionSwitches(LinearExecutable& lx, Region& reg, uint32_t address);
+    void TraceSwitches(LinearExecutable& lx, const FixupIndex& fixups);
     void TraceSwitches(LinearExecutable& lx);
     void AddAddress(size_t& guess_count, uint32_t address);
-    void AddAddressesFromUnknownRegions(size_t& guess_count, std::map<uint32_t, uint32_t>& fixups);
+    void AddAddressesFromUnknownRegions(size_t& guess_count, const FixupIndex& fixups);
     void TraceRemainingRelocs(LinearExecutable& lx);
+    void ScanPrologues();
+    void ProcessMapItem(SymbolMap* map, LinearExecutable& lx, const SymbolMapProperties& item);
     void ProcessMap(SymbolMap* map, LinearExecutable& lx);
     bool IsAlignPattern(uint32_t size, const uint8_t data[]);
     void TraceAlign();
@@ -0,0 +1,109 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "batch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "error.hpp"
+
+static std::mutex s_report_mutex;
+
+Batch::Batch(const std::string& manifest) {
+    std::ifstream is(manifest.c_str());
+    if (!is.is_open()) {
+        throw Error() << "Error opening batch manifest: " << manifest;
+    }
+
+    std::string line;
+    for (size_t line_number = 1; std::getline(is, line); ++line_number) {
+        std::istringstream fields(line);
+        BatchJob job;
+        if (!(fields >> job.executable_file) || job.executable_file[0] == '#') {
+            continue;
+        }
+        if (!(fields >> job.output_file)) {
+            throw Error() << "Missing output file in batch manifest " << manifest << " at line " << line_number;
+        }
+        fields >> job.map_file;
+        m_jobs.push_back(job);
+    }
+}
+
+/* Returns the number of executables that failed. */
+size_t Batch::Run(unsigned workers, const Process& process) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next(0);
+    size_t failures = 0;
+
+    workers = std::max(1u, std::min<unsigned>(workers, m_jobs.size()));
+    std::vector<std::thread> threads;
+    for (unsigned n = 0; n < workers; ++n) {
+        threads.push_back(std::thread([this, &next, &process, &failures]() {
+            for (size_t index = next++; index < m_jobs.size(); index = next++) {
+                RunJob(index, process, failures);
+            }
+        }));
+    }
+    for (size_t n = 0; n < threads.size(); ++n) {
+        threads[n].join();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Batch finished: " << std::dec << m_jobs.size() << " executable(s), " << failures << " failed, "
+              << std::fixed << std::setprecision(3) << seconds << " s on " << workers << " worker(s)" << std::endl;
+    return failures;
+}
+
+void Batch::RunJob(size_t index, const Process& process, size_t& failures) {
+    const BatchJob& job = m_jobs[index];
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::string error;
+
+    try {
+        std::ofstream os(job.output_file.c_str(), std::ofstream::binary | std::ofstream::trunc);
+        if (!os.is_open()) {
+            throw Error() << "Error opening output file: " << job.output_file;
+        }
+        process(job, os);
+        os.close();
+        if (os.fail()) {
+            throw Error() << "Error writing output file: " << job.output_file;
+        }
+    } catch (const std::exception& e) {
+        error = e.what();
+        std::remove(job.output_file.c_str());
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::lock_guard<std::mutex> lock(s_report_mutex);
+    std::cerr << "[" << std::dec << index + 1 << "/" << m_jobs.size() << "] " << job.executable_file;
+    if (error.empty()) {
+        std::cerr << " -> " << job.output_file << " in " << std::fixed << std::setprecision(3) << seconds << " s"
+                  << std::endl;
+    } else {
+        std::cerr << " failed after " << std::fixed << std::setprecision(3) << seconds << " s: " << error << std::endl;
+        ++failures;
+    }
+}
@@ -0,0 +1,50 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LE_DISASM_BATCH_HPP_
+#define LE_DISASM_BATCH_HPP_
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+class BatchJob {
+public:
+    std::string executable_file;
+    std::string output_file;
+    std::string map_file;
+};
+
+/* Disassembles every executable listed in a manifest on a pool of worker threads. Each manifest line holds an
+ * executable, the output file and an optional map file separated by white space, empty lines and lines starting with
+ * '#' are ignored.
+ */
+class Batch {
+public:
+    typedef std::function<void(const BatchJob& job, std::ostream& os)> Process;
+
+    explicit Batch(const std::string& manifest);
+
+    size_t Run(unsigned workers, const Process& process);
+
+private:
+    std::vector<BatchJob> m_jobs;
+
+    void RunJob(size_t index, const Process& process, size_t& failures);
+};
+
+#endif
@@ -25,6 +25,14 @@
 void DisInfo::CallbackPrintAddress(bfd_vma address, disassemble_info* info) {
     info->fprintf_func(info->stream, "0x00%llx", address);
     ((Insn*)info->stream)->memory_address = address;
+    ((Insn*)info->stream)->MarkLastOperandAsTarget();
+}
+
+/* libopcodes is looked up once per process, function local statics are initialized thread safely. */
+disassembler_ftype DisInfo::GetDisassembler(unsigned long mach) {
+    static const disassembler_ftype disasm_32 = disassembler(bfd_arch_i386, FALSE, bfd_mach_i386_i386, NULL);
+    static const disassembler_ftype disasm_16 = disassembler(bfd_arch_i386, FALSE, bfd_mach_i386_i8086, NULL);
+    return mach == bfd_mach_i386_i386 ? disasm_32 : disasm_16;
 }
 
 DisInfo::DisInfo() {
@@ -41,7 +49,7 @@ void DisInfo::Disassemble(uint32_t addr, const void* data, size_t length, Insn&
 
     insn.Reset();
 
-    disassembler_ftype disasm_fn = disassembler(bfd_arch_i386, FALSE, mach, NULL);
+    disassembler_ftype disasm_fn = GetDisassembler(mach);
 
     if (!disasm_fn) {
         throw Error() << "Failed to get disassembler function";
@@ -55,4 +63,5 @@ void DisInfo::Disassemble(uint32_t addr, const void* data, size_t length, Insn&
     if (size > 0) {
         insn.SetTargetAndType(addr, data);
     }
+    insn.SetFlagsFromText();
 }
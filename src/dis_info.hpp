@@ -32,6 +32,7 @@ public:
     void Disassemble(uint32_t addr, const void* data, size_t length, Insn& insn);
 
 private:
+    static disassembler_ftype GetDisassembler(unsigned long mach);
     static void CallbackPrintAddress(bfd_vma address, disassemble_info* info);
 };
 
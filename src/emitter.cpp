@@ -16,11 +16,15 @@
 
 #include "emitter.hpp"
 
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
-#include "analyzer.hpp"
-#include "dis_info.hpp"
+#include "error.hpp"
 #include "image.hpp"
 #include "insn.hpp"
 #include "linear_executable.hpp"
@@ -29,26 +33,50 @@
 #include "symbol_map.hpp"
 #include "symbol_map_properties.hpp"
 
-Emitter::Emitter(LinearExecutable& lx_, Image& img_, Analyzer& anal_, SymbolMap* map_)
-    : m_lx(lx_), m_img(img_), m_regions(anal_.regions), m_label_types(anal_.regions.label_types) {
+Emitter::Emitter(LinearExecutable& lx_, Image& img_, const Snapshot& snapshot_, SymbolMap* map_, unsigned jobs_,
+                 std::ostream& os_)
+    : m_lx(lx_), m_img(img_), m_snapshot(snapshot_), m_output(os_), m_sink(os_.rdbuf()), m_os(&m_sink),
+      m_log(std::cerr), m_jobs(jobs_), m_position(0) {
     m_map = map_;
 }
 
+/* Worker for a chunk of regions, it shares everything but the output streams with its parent. The chunk is printed
+ * straight into os, a string stream that buffers on its own, so the sink gets no buffer of its size.
+ */
+Emitter::Emitter(const Emitter& parent, std::ostream& os, std::ostream& log)
+    : m_lx(parent.m_lx), m_img(parent.m_img), m_snapshot(parent.m_snapshot), m_map(parent.m_map), m_output(os),
+      m_sink(os.rdbuf(), 0), m_os(os.rdbuf()), m_log(log), m_jobs(1), m_position(0) {}
+
 Emitter::~Emitter() {}
 
+/* Returns whether there is a label at address that is already printed at the current output position. */
+bool Emitter::LabelAt(uint32_t address, Type* type) const { return m_snapshot.LabelAt(address, m_position, type); }
+
+uint32_t Emitter::GetLabelType(uint32_t address, Type* type) const { return LabelAt(address, type) ? address : 0; }
+
+bool Emitter::NextLabel(uint32_t address, uint32_t* next) const {
+    return m_snapshot.NextLabel(address, m_position, next);
+}
+
 int Emitter::GetIndent(Type type) {
     if (JUMP == type || CASE == type) {
         return 1;
     } else if (FUNCTION == type || FUNC_GUESS == type) {
-        std::cout << "\n\n";
+        m_os << "\n\n";
         //		print_separator();
     } else if (SWITCH == type) {
-        std::cout << '\n';
+        m_os << '\n';
     }
     return 0;
 }
 
 std::ostream& Emitter::PrintTypedAddress(std::ostream& os, uint32_t address, Type type) {
+    size_t length;
+    const char* name = m_snapshot.LabelName(address, type, &length);
+    if (name) {
+        return os.write(name, length);
+    }
+
     if (m_map) {
         const SymbolMapProperties* item = m_map->GetMapItem(address);
         if (item) {
@@ -56,36 +84,20 @@ std::ostream& Emitter::PrintTypedAddress(std::ostream& os, uint32_t address, Typ
         }
     }
 
-    switch (type) {
-        case FUNCTION:
-            return PrintAddress(os, address, "_") << "_func";
-        case FUNC_GUESS:
-            return PrintAddress(os, address, "_") << "_func";
-        case JUMP:
-            return PrintAddress(os, address, "_") << "_jump";
-        case DATA:
-            return PrintAddress(os, address, "_") << "_data";
-        case SWITCH:
-            return PrintAddress(os, address, "_") << "_switch";
-        case CASE:
-            return PrintAddress(os, address, "_") << "_case";
-        default:
-            return PrintAddress(os, address, "_") << "_unknown";
-    }
+    return PrintAddress(os, address, "_") << LabelSuffix(type);
 }
 
 std::ostream& Emitter::PrintLabel(uint32_t address, Type type, char const* prefix) {
-    for (int indent = GetIndent(type); indent-- > 0; std::cout << '\t') {
+    for (int indent = GetIndent(type); indent-- > 0; m_os << '\t') {
         ;
     }
-    PrintTypedAddress(std::cout << prefix, address, type) << ":";
-    return std::cout;
+    PrintTypedAddress(m_os << prefix, address, type) << ":";
+    return m_os;
 }
 
 bool Emitter::DataIsAddress(const ImageObject& obj, uint32_t addr, size_t len) {
     if (len >= 4) {
-        const std::map<uint32_t, uint32_t>& fups = m_lx.fixups[obj.Index()];
-        return fups.find(addr - obj.BaseAddress()) != fups.end();
+        return obj.IsRelocation(addr);
     }
     return false;
 }
@@ -94,8 +106,19 @@ bool Emitter::DataIsZeros(const ImageObject& obj, uint32_t addr, size_t len, siz
     size_t x;
     const uint8_t* data = obj.GetDataAt(addr);
 
-    for (x = 0; x < len; x++) {
-        if (data[x] != 0) {
+    /* Ranges that were never loaded nor patched are known to be zero and are skipped without reading them. */
+    for (x = 0; x < len;) {
+        size_t chunk = std::min<size_t>(len - x, 0x1000);
+        size_t n = 0;
+        if (obj.IsBacked(addr + x, chunk)) {
+            while (n < chunk && data[x + n] == 0) {
+                ++n;
+            }
+        } else {
+            n = chunk;
+        }
+        x += n;
+        if (n < chunk) {
             break;
         }
     }
@@ -136,44 +159,36 @@ void Emitter::PrintEscapedString(const uint8_t* data, size_t len) {
 
     for (n = 0; n < len; n++) {
         if (data[n] == '\t')
-            std::cout << "\\t";
+            m_os << "\\t";
         else if (data[n] == '\r')
-            std::cout << "\\r";
+            m_os << "\\r";
         else if (data[n] == '\n')
-            std::cout << "\\n";
+            m_os << "\\n";
         else if (data[n] == '\\')
-            std::cout << "\\\\";
+            m_os << "\\\\";
         else if (data[n] == '"')
-            std::cout << "\\\"";
+            m_os << "\\\"";
         else
-            std::cout << (char)data[n];
+            m_os << (char)data[n];
     }
 }
 
 void Emitter::CompleteStringQuoting(int& bytes_in_line, int resetTo) {
     if (bytes_in_line > 0) {
-        std::cout << "\"\n";
+        m_os << "\"\n";
         bytes_in_line = resetTo;
     }
 }
 
-size_t Emitter::GetLen(const Region& reg, const ImageObject& obj,
-                       std::map<uint32_t /*offset*/, uint32_t /*address*/>& fups,
-                       std::map<uint32_t, uint32_t>::const_iterator& itr, uint32_t address) {
+size_t Emitter::GetLen(const Region& reg, const ImageObject& obj, uint32_t address) {
     size_t len = reg.EndAddress() - address;
 
-    std::map<uint32_t, Type>::iterator label = m_label_types.upper_bound(address);
-    if (m_label_types.end() != label) {
-        len = std::min<size_t>(len, label->first - address);
-    }
-
-    while (fups.end() != itr and itr->first <= address - obj.BaseAddress()) {
-        ++itr;
+    uint32_t label;
+    if (NextLabel(address, &label)) {
+        len = std::min<size_t>(len, label - address);
     }
 
-    if (itr != fups.end()) {
-        len = std::min<size_t>(len, itr->first - (address - obj.BaseAddress()));
-    }
+    len = std::min<size_t>(len, obj.NextRelocation(address + 1) - address);
     return len;
 }
 
@@ -187,46 +202,46 @@ void Emitter::PrintDataAfterFixup(const ImageObject& obj, uint32_t& address, siz
             CompleteStringQuoting(bytes_in_line);
             uint32_t value = ReadLe<uint32_t>(obj.GetDataAt(address));
             Type type;
-            if (value != m_regions.GetLabelType(value, &type)) {
+            if (value != GetLabelType(value, &type)) {
                 type = UNKNOWN;
-                PrintAddress(std::cerr, value, "Warning: Printing address without label: 0x") << std::endl;
+                PrintAddress(m_log, value, "Warning: Printing address without label: 0x") << std::endl;
             }
-            PrintTypedAddress(std::cout << "\t\t.long   ", value, type) << std::endl;
+            PrintTypedAddress(m_os << "\t\t.long   ", value, type) << '\n';
 
             address += 4;
             len -= 4;
         } else if (DataIsZeros(obj, address, len, size)) {
             CompleteStringQuoting(bytes_in_line);
 
-            std::cout << "\t\t.fill   0x" << std::hex << size << std::endl;
+            m_os << "\t\t.fill   0x" << std::hex << size << '\n';
             address += size;
             len -= size;
         } else if (DataIsString(obj, address, len, size, zt)) {
             CompleteStringQuoting(bytes_in_line);
 
             if (zt) {
-                std::cout << "\t\t.string \"";
+                m_os << "\t\t.string \"";
             } else {
-                std::cout << "\t\t.ascii   \"";
+                m_os << "\t\t.ascii   \"";
             }
             PrintEscapedString(obj.GetDataAt(address), size - zt);
 
-            std::cout << "\"\n";
+            m_os << "\"\n";
 
             address += size;
             len -= size;
         } else {
             char buffer[8];
 
-            if (bytes_in_line == 0) std::cout << "\t\t.ascii  \"";
+            if (bytes_in_line == 0) m_os << "\t\t.ascii  \"";
 
             snprintf(buffer, sizeof(buffer), "\\x%02x", *obj.GetDataAt(address));
-            std::cout << buffer;
+            m_os << buffer;
 
             bytes_in_line += 1;
 
             if (bytes_in_line == 8) {
-                std::cout << "\"\n";
+                m_os << "\"\n";
                 bytes_in_line = 0;
             }
 
@@ -240,49 +255,47 @@ void Emitter::PrintEip() {
     const ImageObject& obj = m_img.ObjectAt(m_lx.EntryPointAddress());
 
     if (obj.GetBitness() == BITNESS_32BIT) {
-        std::cout << ".code32" << std::endl;
+        m_os << ".code32\n";
     } else {
-        std::cout << ".code16" << std::endl;
+        m_os << ".code16\n";
     }
 
-    std::cout << ".text" << std::endl;
-    std::cout << ".globl _start" << std::endl;
-    std::cout << "_start:" << std::endl;
+    m_os << ".text\n";
+    m_os << ".globl _start\n";
+    m_os << "_start:\n";
 
-    PrintTypedAddress(std::cout << "\t\tjmp\t", m_lx.EntryPointAddress(), FUNCTION) << std::endl;
+    PrintTypedAddress(m_os << "\t\tjmp\t", m_lx.EntryPointAddress(), FUNCTION) << '\n';
 }
 
 void Emitter::PrintUnknownTypeRegion(const Region& reg) {
-    const ImageObject& obj = m_img.ObjectAt(reg.Address());
+    const ImageObject& obj = *reg.ImageObjectPointer();
 
     /* Emit unidentified region data for reference. Hex editors like wxHexEditor could be used to find and disassemble
      * the rendered raw data that could help further improve le_disasm analyzer and actual reengineering projects.
      */
-    std::cout << "\n\t\t/* Skipped " << std::dec << reg.Size() << " bytes of "
+    m_os << "\n\t\t/* Skipped " << std::dec << reg.Size() << " bytes of "
               << (obj.IsExecutable() ? "executable " : "") << reg.GetType() << " type data at virtual address 0x"
               << std::setfill('0') << std::setw(8) << std::hex << std::noshowbase << (uint32_t)reg.Address() << ":";
     const uint8_t* data_pointer = obj.GetDataAt(reg.Address());
     for (uint8_t index = 0; index < reg.Size() && data_pointer; ++index) {
         if (index >= 16) {
-            std::cout << "\n\t\t * ...";
+            m_os << "\n\t\t * ...";
             break;
         }
         if (index % 8 == 0) {
-            std::cout << "\n\t\t *\t";
+            m_os << "\n\t\t *\t";
         }
-        std::cout << std::setfill('0') << std::setw(2) << std::hex << std::noshowbase << (uint32_t)data_pointer[index];
+        m_os << std::setfill('0') << std::setw(2) << std::hex << std::noshowbase << (uint32_t)data_pointer[index];
     }
-    std::cout << "\n\t\t */" << std::endl;
+    m_os << "\n\t\t */\n";
 }
 
 std::string Emitter::ReplaceAddressesWithLabels(Insn& inst) {
     std::ostringstream oss;
-    size_t n, start;
+    size_t start;
     uint32_t addr;
-    std::string addr_str;
     std::string comment;
     char prefix_symbol;
-    const std::string& str = inst.text;
 
     /* Many opcodes support displacement in indirect addressing modes.
      * Example: mov    %edx,-0x10(%ebp) .
@@ -290,51 +303,43 @@ std::string Emitter::ReplaceAddressesWithLabels(Insn& inst) {
      * as unsigned fixup addresses.
      */
 
-    n = str.find("0x");
-    if (n == std::string::npos) return str;
+    if (inst.operand_count == 0) return std::string(inst.text, inst.text_length);
 
     start = 0;
 
-    do {
-        prefix_symbol = *str.substr(n - sizeof(char), sizeof(char)).c_str();
-        oss << str.substr(start, n - start);
-
-        if (n + 2 >= str.length()) break;
-
-        n += 2;
-        start = n;
+    for (size_t i = 0; i < inst.operand_count; ++i) {
+        const Insn::Operand& operand = inst.operands[i];
 
-        while (n < str.length() and isxdigit(str[n])) n++;
+        prefix_symbol = operand.offset > 0 ? inst.text[operand.offset - 1] : 0;
+        oss.write(&inst.text[start], operand.offset - start);
 
-        addr_str = str.substr(start, n - start);
-        addr = strtol(addr_str.c_str(), NULL, 16);
+        addr = operand.value;
         if (inst.GetBitness() == BITNESS_16BIT and inst.memory_address == addr and inst.type == Insn::MISC) {
             /* assume that ds and cs equal segment base in 16 bit mode */
             uint32_t virtual_address = inst.BaseAddress() + inst.memory_address;
-            Region* reg = m_regions.RegionContaining(virtual_address);
+            const Region* reg = m_snapshot.RegionContaining(virtual_address);
             if (reg and reg->GetType() == DATA) {
                 // addr = virtual_address; GCC throws "relocation truncated to fit: R_386_16 against .data" error.
             }
         }
-        std::map<uint32_t, Type>::const_iterator lab = m_label_types.find(addr);
+        Type lab;
         if (prefix_symbol != '-' /* && prefix_symbol != '$' */
-            && m_label_types.end() != lab) {
-            PrintTypedAddress(oss, addr, lab->second);
+            && LabelAt(addr, &lab)) {
+            PrintTypedAddress(oss, addr, lab);
         } else {
             PrintAddress(oss, addr);
 
-            if (m_lx.fixup_addresses.find(addr) != m_lx.fixup_addresses.end()) {
+            if (m_snapshot.IsFixupAddress(addr)) {
                 m_img.ObjectAt(addr);
                 comment = " /* Warning: address points to a valid object/reloc, but no label found */";
             }
         }
 
-        start = n;
-        n = str.find("0x", start);
-    } while (n != std::string::npos);
+        start = operand.offset + operand.length;
+    }
 
-    if (start < str.length()) {
-        oss << str.substr(start);
+    if (start < inst.text_length) {
+        oss.write(&inst.text[start], inst.text_length - start);
     }
     if (!comment.empty()) {
         oss << comment;
@@ -350,13 +355,13 @@ void Emitter::PrintInstruction(Insn& inst) {
 
     n = str.find("(287 only)");
     if (n != std::string::npos) {
-        std::cout << "\t\t/* " << str << " -- ignored */\n";
+        m_os << "\t\t/* " << str << " -- ignored */\n";
         return;
     }
 
     n = str.find("(8087 only)");
     if (n != std::string::npos) {
-        std::cout << "\t\t/* " << str << " -- ignored */\n";
+        m_os << "\t\t/* " << str << " -- ignored */\n";
         return;
     }
 
@@ -370,37 +375,36 @@ void Emitter::PrintInstruction(Insn& inst) {
     } else if (str == "lea    0x000000(%edx,%eiz,1),%edx") {
         str = "lea    0x000000(%edx),%edx";
     }
-    std::cout << "\t\t" << str;
+    m_os << "\t\t" << str;
 
     if (str == "data16" or str == "data32") {
-        std::cout << " ";
+        m_os << " ";
     } else {
-        std::cout << "\n";
+        m_os << "\n";
     }
 }
 
 void Emitter::PrintCodeTypeRegion(const Region& reg) {
-    const ImageObject& obj = m_img.ObjectAt(reg.Address());
-    DisInfo disasm;
+    const ImageObject& obj = *reg.ImageObjectPointer();
     Insn inst(std::addressof(obj));
 
     for (uint32_t addr = reg.Address(); addr < reg.EndAddress();) {
-        std::map<uint32_t, Type>::iterator type = m_label_types.find(addr);
-        if (m_label_types.end() != type) {
-            //			if (CASE == type->second) {	// newline makes case not be part of function
-            std::cout << std::endl;
+        Type type;
+        bool labeled = LabelAt(addr, &type);
+        if (labeled) {
+            //			if (CASE == type) {	// newline makes case not be part of function
+            m_os << '\n';
             //			}
-            PrintLabel(addr, type->second) << std::endl;
+            PrintLabel(addr, type) << '\n';
         }
 
-        disasm.Disassemble(addr, obj.GetDataAt(addr), reg.EndAddress() - addr, inst);
-        if (m_label_types.end() == type && inst.size > 1) {  // hack for corrupted libraries
-            type = m_label_types.find(addr + inst.size / 2);
-            if (m_label_types.end() != type) {
-                PrintLabel(addr + inst.size / 2, type->second)
+        m_disasm.Disassemble(addr, obj.GetDataAt(addr), reg.EndAddress() - addr, inst);
+        if (!labeled && inst.size > 1) {  // hack for corrupted libraries
+            if (LabelAt(addr + inst.size / 2, &type)) {
+                PrintLabel(addr + inst.size / 2, type)
                     << "\t/* WARNING: instructions around this label are incorrect, generated just to workaround "
                        "corrupted library */"
-                    << std::endl;
+                    << '\n';
             }
         }
         PrintInstruction(inst);
@@ -409,74 +413,58 @@ void Emitter::PrintCodeTypeRegion(const Region& reg) {
 }
 
 void Emitter::PrintDataTypeRegion(const Region& reg) {
-    const ImageObject& obj = m_img.ObjectAt(reg.Address());
+    const ImageObject& obj = *reg.ImageObjectPointer();
     int bytes_in_line = 0;
     uint32_t addr = reg.Address();
-    std::map<uint32_t /*offset*/, uint32_t /*address*/>& fups = m_lx.fixups[obj.Index()];
-    for (std::map<uint32_t, uint32_t>::const_iterator itr = fups.begin(); addr < reg.EndAddress();) {
-        std::map<uint32_t, Type>::iterator label = m_label_types.find(addr);
-        if (m_label_types.end() != label) {
+    while (addr < reg.EndAddress()) {
+        Type type;
+        if (LabelAt(addr, &type)) {
             CompleteStringQuoting(bytes_in_line);
-            std::cout << std::endl;
+            m_os << '\n';
 
-            PrintLabel(addr, DATA) << std::endl;
+            PrintLabel(addr, DATA) << '\n';
         }
-        size_t len = GetLen(reg, obj, fups, itr, addr);
+        size_t len = GetLen(reg, obj, addr);
         PrintDataAfterFixup(obj, addr, len, bytes_in_line);
     }
     CompleteStringQuoting(bytes_in_line, bytes_in_line);
 }
 
+
 void Emitter::PrintSwitchTypeRegion(const Region& reg) {
-    const ImageObject& obj = m_img.ObjectAt(reg.Address());
+    const ImageObject& obj = *reg.ImageObjectPointer();
     uint32_t func_addr, addr = reg.Address();
+    Type type;
 
     /* TODO: limit by relocs */
-    PrintLabel(addr, m_label_types[addr]) << std::endl;
-    std::map<uint32_t, Type>::iterator next_label = m_label_types.upper_bound(addr);
+    LabelAt(addr, &type);
+    PrintLabel(addr, type) << '\n';
+    uint32_t next_label;
+    bool has_next_label = NextLabel(addr, &next_label);
 
     while (addr < reg.EndAddress()) {
-        if (m_label_types.end() != next_label and addr == next_label->first) {
-            PrintLabel(addr, next_label->second) << std::endl;
-            next_label = m_label_types.upper_bound(addr);
+        m_position = Snapshot::OutputPosition(addr, false);
+        if (has_next_label and addr == next_label and LabelAt(addr, &type)) {
+            PrintLabel(addr, type) << '\n';
+            has_next_label = NextLabel(addr, &next_label);
         }
 
-        switch (obj.GetBitness()) {
-            case Bitness::BITNESS_32BIT: {
-                func_addr = ReadLe<uint32_t>(obj.GetDataAt(addr));
-                if (m_img.IsValidAddress(func_addr)) {
-                    if (addr < func_addr) {
-                        if (m_label_types.end() == m_label_types.find(func_addr)) {
-                            m_label_types[func_addr] = CASE;
-                        }
-                    }
-                    PrintTypedAddress(std::cout << "\t\t.long   ", func_addr, m_label_types[func_addr]) << std::endl;
-                } else {
-                    std::cout << "\t\t.long   0x" << std::hex << func_addr << std::endl;
-                }
-                addr += sizeof(uint32_t);
-            } break;
-            case Bitness::BITNESS_16BIT: {
-                func_addr = ReadLe<uint16_t>(obj.GetDataAt(addr));
-                if (m_img.IsValidAddress(func_addr)) {
-                    if (addr < func_addr) {
-                        if (m_label_types.end() == m_label_types.find(func_addr)) {
-                            m_label_types[func_addr] = CASE;
-                        }
-                    }
-                    PrintTypedAddress(std::cout << "\t\t.short   ", func_addr, m_label_types[func_addr]) << std::endl;
-                } else {
-                    std::cout << "\t\t.short   0x" << std::hex << func_addr << std::endl;
-                }
-                addr += sizeof(uint16_t);
-            } break;
+        size_t size = Snapshot::SwitchEntryAt(obj, addr, &func_addr);
+        const char* directive = size == sizeof(uint32_t) ? "\t\t.long   " : "\t\t.short   ";
+        m_position = Snapshot::OutputPosition(addr, true);
+        if (m_img.IsValidAddress(func_addr)) {
+            LabelAt(func_addr, &type);
+            PrintTypedAddress(m_os << directive, func_addr, type) << '\n';
+        } else {
+            m_os << directive << "0x" << std::hex << func_addr << '\n';
         }
+        addr += size;
     }
-    std::cout << std::endl;
+    m_os << '\n';
 }
 
 void Emitter::PrintAlignmentTypeRegion(const Region& reg) {
-    Region* const next_reg = m_regions.NextRegion(reg);
+    const Region* const next_reg = m_snapshot.NextRegion(reg);
     assert(next_reg);
 
     uint32_t alignment_next = next_reg->Alignment();
@@ -491,7 +479,7 @@ void Emitter::PrintAlignmentTypeRegion(const Region& reg) {
     if (alignment > alignment_next) {
         alignment = alignment_next;
     }
-    std::cout << std::endl << ".align " << std::dec << alignment << std::endl;
+    m_os << "\n.align " << std::dec << alignment << '\n';
 }
 
 void Emitter::PrintRegion(const Region& reg) {
@@ -522,15 +510,15 @@ void Emitter::PrintChangedSectionType(const Region& reg, const Region* const reg
 
     if (reg_prev and reg_prev->GetBitness() != reg.GetBitness()) {
         if (reg.GetBitness() == BITNESS_32BIT) {
-            std::cout << std::endl << ".code32" << std::endl;
+            m_os << "\n.code32\n";
         } else {
-            std::cout << std::endl << ".code16" << std::endl;
+            m_os << "\n.code16\n";
         }
     }
 
     if (reg.GetType() == DATA) {
         if (section != DATA) {
-            std::cout << std::endl << sections[section = DATA] << std::endl;
+            m_os << '\n' << sections[section = DATA] << '\n';
         }
     } else {
         if (section != CODE) {
@@ -539,23 +527,30 @@ void Emitter::PrintChangedSectionType(const Region& reg, const Region* const reg
             } else {
                 section = CODE;
             }
-            std::cout << std::endl << sections[section] << std::endl;
+            m_os << '\n' << sections[section] << '\n';
         }
     }
 }
 
-void Emitter::PrintCode() {
-    const Region* prev = NULL;
-    const Region* next;
-    Type section = CODE;
-
-    std::cerr << "Region count: " << m_regions.regions.size() << std::endl;
+/* Returns the section PrintChangedSectionType() has selected after reg. */
+static Type SectionAfter(const Region& reg, Type section) {
+    if (reg.GetType() == DATA) {
+        return DATA;
+    }
+    if (section != CODE) {
+        return reg.IsExecutable() ? CODE : DATA;
+    }
+    return section;
+}
 
-    PrintEip();
+void Emitter::PrintRegions(size_t begin, size_t end, Type section) {
+    const std::vector<Region>& regions = m_snapshot.GetRegions();
+    const Region* prev = begin > 0 ? &regions[begin - 1] : NULL;
+    const Region* next;
 
-    for (std::map<uint32_t, Region>::const_iterator itr = m_regions.regions.begin(); itr != m_regions.regions.end();
-         ++itr) {
-        const Region& reg = itr->second;
+    for (size_t n = begin; n < end; ++n) {
+        const Region& reg = regions[n];
+        m_position = Snapshot::OutputPosition(reg.Address(), false);
 
         PrintChangedSectionType(reg, prev, section);
 
@@ -563,11 +558,12 @@ void Emitter::PrintCode() {
 
         assert(prev == NULL || prev->EndAddress() <= reg.Address());
 
-        next = m_regions.NextRegion(reg);
+        next = n + 1 < regions.size() ? &regions[n + 1] : NULL;
         if (next == NULL or next->Address() > reg.EndAddress()) {
             Type type;
-            if (m_regions.GetLabelType(reg.EndAddress(), &type)) {
-                PrintLabel(reg.EndAddress(), type) << std::endl;
+            m_position = Snapshot::OutputPosition(reg.EndAddress(), false);
+            if (GetLabelType(reg.EndAddress(), &type)) {
+                PrintLabel(reg.EndAddress(), type) << '\n';
             }
         }
 
@@ -575,4 +571,119 @@ void Emitter::PrintCode() {
     }
 }
 
-void Emitter::Run() { PrintCode(); }
+/* Splits the regions into chunks of about equal size, prints each chunk into a buffer of its own on the worker
+ * threads and writes the buffers out in address order.
+ */
+void Emitter::PrintRegionsParallel() {
+    const std::vector<Region>& regions = m_snapshot.GetRegions();
+    uint64_t total_size = 0;
+    for (size_t n = 0; n < regions.size(); ++n) {
+        total_size += regions[n].Size();
+    }
+
+    uint64_t chunk_size = total_size / (m_jobs * CHUNKS_PER_JOB) + 1;
+    uint64_t size = chunk_size;
+    std::vector<size_t> starts;
+    std::vector<Type> sections;
+    Type section = CODE;
+    for (size_t n = 0; n < regions.size(); ++n) {
+        if (size >= chunk_size) {
+            starts.push_back(n);
+            sections.push_back(section);
+            size = 0;
+        }
+        size += regions[n].Size();
+        section = SectionAfter(regions[n], section);
+    }
+    starts.push_back(regions.size());
+
+    size_t chunks = sections.size();
+    std::vector<std::string> texts(chunks);
+    std::vector<std::string> logs(chunks);
+    std::vector<std::string> errors(chunks);
+    std::vector<bool> done(chunks, false);
+    std::mutex mutex;
+    std::condition_variable progress;
+    std::atomic<size_t> next(0);
+    size_t written = 0;
+    std::vector<std::thread> workers;
+    for (unsigned job = 0; job < m_jobs && job < chunks; ++job) {
+        workers.push_back(std::thread([this, &starts, &sections, &texts, &logs, &errors, &done, &mutex, &progress,
+                                       &next, &written, chunks]() {
+            for (size_t chunk = next++; chunk < chunks; chunk = next++) {
+                {
+                    /* Stay a few chunks ahead of the writer at most, finished chunks are held in memory. */
+                    std::unique_lock<std::mutex> lock(mutex);
+                    while (chunk >= written + 2 * m_jobs) {
+                        progress.wait(lock);
+                    }
+                }
+                std::ostringstream text, log;
+                std::string error;
+                try {
+                    Emitter emitter(*this, text, log);
+                    emitter.PrintRegions(starts[chunk], starts[chunk + 1], sections[chunk]);
+                } catch (const std::exception& e) {
+                    error = e.what();
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                texts[chunk] = text.str();
+                logs[chunk] = log.str();
+                errors[chunk] = error;
+                done[chunk] = true;
+                progress.notify_all();
+            }
+        }));
+    }
+
+    /* Chunks are written in address order as soon as they are done. */
+    std::string error;
+    for (size_t chunk = 0; chunk < chunks && error.empty(); ++chunk) {
+        std::string text, log;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!done[chunk]) {
+                progress.wait(lock);
+            }
+            text.swap(texts[chunk]);
+            log.swap(logs[chunk]);
+            error = errors[chunk];
+            written = chunk + 1;
+            progress.notify_all();
+        }
+        m_os.write(text.data(), text.size());
+        m_log << log;
+    }
+
+    if (!error.empty()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        next = chunks;
+        written = chunks;
+        progress.notify_all();
+    }
+    for (size_t n = 0; n < workers.size(); ++n) {
+        workers[n].join();
+    }
+    if (!error.empty()) {
+        throw Error() << error;
+    }
+}
+
+void Emitter::PrintCode() {
+    std::cerr << "Region count: " << m_snapshot.GetRegions().size() << std::endl;
+
+    PrintEip();
+
+    if (m_jobs > 1) {
+        PrintRegionsParallel();
+    } else {
+        PrintRegions(0, m_snapshot.GetRegions().size(), CODE);
+    }
+}
+
+void Emitter::Run() {
+    PrintCode();
+    if (!m_os.flush()) {
+        m_output.setstate(std::ios::badbit);
+    }
+}
@@ -18,42 +18,65 @@
 #define LE_DISASM_EMITTER_HPP_
 
 #include <cstdint>
-#include <map>
+#include <iostream>
+#include <string>
+#include <vector>
 
+#include "dis_info.hpp"
+#include "output_sink.hpp"
+#include "snapshot.hpp"
 #include "type.hpp"
 
 class LinearExecutable;
 class Image;
-class Analyzer;
 class SymbolMap;
-class Regions;
 class Region;
 class ImageObject;
 class Insn;
 
 class Emitter {
 public:
-    Emitter(LinearExecutable& lx, Image& img, Analyzer& anal, SymbolMap* map);
+    Emitter(LinearExecutable& lx, Image& img, const Snapshot& snapshot, SymbolMap* map, unsigned jobs,
+            std::ostream& os = std::cout);
     virtual ~Emitter();
     void Run();
 
 private:
+    /* Regions printed per worker thread are split into this many chunks per job to balance the load. */
+    enum { CHUNKS_PER_JOB = 8 };
+
     LinearExecutable& m_lx;
     Image& m_img;
-    Regions& m_regions;
-    std::map<uint32_t, Type>& m_label_types;
+    const Snapshot& m_snapshot;
     SymbolMap* m_map;
+    std::ostream& m_output;
+    /* All printing goes to m_os, which buffers it in m_sink without flushing until the end of Run(). Chunk workers
+     * print to their string stream directly and leave m_sink unused.
+     */
+    OutputSink m_sink;
+    std::ostream m_os;
+    std::ostream& m_log;
+    unsigned m_jobs;
+    /* Every worker decodes its instructions with a libopcodes instance of its own. */
+    DisInfo m_disasm;
+    /* Output position of the text being printed, labels of switch tables printed later are hidden before it. */
+    uint64_t m_position;
+
+    Emitter(const Emitter& parent, std::ostream& os, std::ostream& log);
+
+    bool LabelAt(uint32_t address, Type* type) const;
+    uint32_t GetLabelType(uint32_t address, Type* type) const;
+    bool NextLabel(uint32_t address, uint32_t* next) const;
 
-    static int GetIndent(Type type);
+    int GetIndent(Type type);
     std::ostream& PrintTypedAddress(std::ostream& os, uint32_t address, Type type);
     std::ostream& PrintLabel(uint32_t address, Type type, char const* prefix = "");
     bool DataIsAddress(const ImageObject& obj, uint32_t addr, size_t len);
     bool DataIsZeros(const ImageObject& obj, uint32_t addr, size_t len, size_t& rlen);
     bool DataIsString(const ImageObject& obj, uint32_t addr, size_t len, size_t& rlen, bool& zero_terminated);
-    static void PrintEscapedString(const uint8_t* data, size_t len);
-    static void CompleteStringQuoting(int& bytes_in_line, int resetTo = 0);
-    size_t GetLen(const Region& reg, const ImageObject& obj, std::map<uint32_t, uint32_t>& fups,
-                  std::map<uint32_t, uint32_t>::const_iterator& itr, uint32_t address);
+    void PrintEscapedString(const uint8_t* data, size_t len);
+    void CompleteStringQuoting(int& bytes_in_line, int resetTo = 0);
+    size_t GetLen(const Region& reg, const ImageObject& obj, uint32_t address);
     void PrintDataAfterFixup(const ImageObject& obj, uint32_t& address, size_t len, int& bytes_in_line);
     void PrintEip();
     void PrintCode();
@@ -66,6 +89,8 @@ private:
     void PrintSwitchTypeRegion(const Region& reg);
     void PrintAlignmentTypeRegion(const Region& reg);
     void PrintChangedSectionType(const Region& reg, const Region* const reg_prev, Type& section);
+    void PrintRegions(size_t begin, size_t end, Type section);
+    void PrintRegionsParallel();
 };
 
 #endif
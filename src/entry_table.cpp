@@ -0,0 +1,77 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "entry_table.hpp"
+
+#include "error.hpp"
+#include "little_endian.hpp"
+#include "object_header.hpp"
+
+void EntryTable::ReadFrom(ByteCursor& cursor) {
+    m_entries.clear();
+    for (uint8_t count = cursor.Read<uint8_t>(); count != 0; count = cursor.Read<uint8_t>()) {
+        uint8_t type = cursor.Read<uint8_t>() & 0x7f;
+        Entry entry = {0, 0};
+
+        if (type == UNUSED) {
+            m_entries.insert(m_entries.end(), count, entry);
+            continue;
+        }
+
+        uint16_t object = cursor.Read<uint16_t>();
+        for (uint8_t n = 0; n < count; ++n) {
+            switch (type) {
+                case ENTRY_16BIT:
+                    cursor.Require(sizeof(uint8_t) + sizeof(uint16_t)).Skip(sizeof(uint8_t));
+                    entry.object = object;
+                    entry.offset = cursor.ReadUnchecked<uint16_t>();
+                    break;
+                case CALL_GATE_286:
+                    cursor.Require(sizeof(uint8_t) + 2 * sizeof(uint16_t)).Skip(sizeof(uint8_t));
+                    entry.object = object;
+                    entry.offset = cursor.ReadUnchecked<uint16_t>();
+                    cursor.Skip(sizeof(uint16_t));
+                    break;
+                case ENTRY_32BIT:
+                    cursor.Require(sizeof(uint8_t) + sizeof(uint32_t)).Skip(sizeof(uint8_t));
+                    entry.object = object;
+                    entry.offset = cursor.ReadUnchecked<uint32_t>();
+                    break;
+                case FORWARDER:
+                    /* forwarded entries resolve to other modules */
+                    cursor.Skip(sizeof(uint8_t) + sizeof(uint16_t) + sizeof(uint32_t));
+                    entry.object = 0;
+                    entry.offset = 0;
+                    break;
+                default:
+                    throw Error() << "Invalid entry table bundle type: " << (int)type;
+            }
+            m_entries.push_back(entry);
+        }
+    }
+}
+
+bool EntryTable::Resolve(uint32_t ordinal, const std::vector<ObjectHeader>& objects, uint32_t& address) const {
+    if (ordinal < 1 || ordinal > m_entries.size()) {
+        return false;
+    }
+    const Entry& entry = m_entries[ordinal - 1];
+    if (entry.object < 1 || entry.object > objects.size()) {
+        return false;
+    }
+    address = objects[entry.object - 1].base_address + entry.offset;
+    return true;
+}
@@ -0,0 +1,43 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LE_DISASM_ENTRY_TABLE_HPP_
+#define LE_DISASM_ENTRY_TABLE_HPP_
+
+#include <cstdint>
+#include <vector>
+
+class ByteCursor;
+class ObjectHeader;
+
+class EntryTable {
+public:
+    enum BundleType { UNUSED = 0, ENTRY_16BIT = 1, CALL_GATE_286 = 2, ENTRY_32BIT = 3, FORWARDER = 4 };
+
+    void ReadFrom(ByteCursor& cursor);
+    bool Resolve(uint32_t ordinal, const std::vector<ObjectHeader>& objects, uint32_t& address) const;
+
+private:
+    class Entry {
+    public:
+        uint16_t object;
+        uint32_t offset;
+    };
+
+    std::vector<Entry> m_entries;
+};
+
+#endif
@@ -18,76 +18,181 @@
 
 #include "fixup.hpp"
 
+#include "entry_table.hpp"
 #include "error.hpp"
 #include "little_endian.hpp"
 #include "object_header.hpp"
 
-uint8_t Fixup::ThrowOnInvalidAddressFlags(std::istream& is) {
-    uint8_t addr_flags;
-    ReadLe(is, addr_flags);
-    if ((addr_flags & 0x20) != 0) {
-        throw Error() << "Fixup lists not supported";
+/* Indexed by the source type nibble of the source flags. */
+static const struct {
+    bool valid;
+    bool has_target_offset;
+    /* Bytes patched at the source offset. */
+    uint8_t size;
+} kSourceTypes[16] = {
+    {true, true, 1},    /* 0x0: byte */
+    {false, false, 0},  /* 0x1 */
+    {true, false, 2},   /* 0x2: 16-bit selector */
+    {true, true, 4},    /* 0x3: 16:16 pointer */
+    {false, false, 0},  /* 0x4 */
+    {true, true, 2},    /* 0x5: 16-bit offset */
+    {true, true, 6},    /* 0x6: 16:32 pointer */
+    {true, true, 4},    /* 0x7: 32-bit offset */
+    {true, true, 4},    /* 0x8: 32-bit self-relative offset */
+    {false, false, 0}, {false, false, 0}, {false, false, 0}, {false, false, 0},
+    {false, false, 0}, {false, false, 0}, {false, false, 0}};
+
+/* Field widths selected by single bits of the target flags. */
+static const uint8_t kOrdinalSize[2] = {sizeof(uint8_t), sizeof(uint16_t)};
+static const uint8_t kOffsetSize[2] = {sizeof(uint16_t), sizeof(uint32_t)};
+
+bool Fixup::IsResolved() const { return target_type == INTERNAL || target_type == INTERNAL_ENTRY; }
+
+bool Fixup::IsRelative() const { return source_type == SOURCE_RELATIVE_32; }
+
+size_t Fixup::SourceSize() const { return kSourceTypes[source_type].size; }
+
+FixupDecoder::FixupDecoder(const std::vector<ObjectHeader>& objects, const EntryTable& entry_table)
+    : m_objects(objects), m_entry_table(entry_table) {}
+
+uint8_t FixupDecoder::ThrowOnInvalidSourceFlags(uint8_t source_flags) {
+    if (!kSourceTypes[source_flags & SOURCE_TYPE_MASK].valid) {
+        throw Error() << "Unsupported fixup source type in 0x" << std::hex << (int)source_flags;
+    }
+    return source_flags;
+}
+
+uint8_t FixupDecoder::ThrowOnInvalidTargetFlags(uint8_t target_flags) {
+    if ((target_flags & INTERNAL_CHAINING) != 0) {
+        throw Error() << "Internal chaining fixups are not supported in 0x" << std::hex << (int)target_flags;
     }
-    return addr_flags;
+    return target_flags;
 }
 
-uint8_t Fixup::ThrowOnInvalidRelocFlags(std::istream& is) {
-    uint8_t reloc_flags;
-    ReadLe(is, reloc_flags);
-    if ((reloc_flags & 0x3) != 0x0) {
-        throw Error() << "Unsupported reloc type in 0x" << std::hex << (int)reloc_flags;
+/* Size of the target data following the source offset or source count field, including the additive value. */
+size_t FixupDecoder::TargetSize(uint8_t source_flags, uint8_t target_flags) {
+    size_t size = kOrdinalSize[(target_flags & ORDINAL_16) != 0];
+    switch (target_flags & TARGET_TYPE_MASK) {
+        case Fixup::INTERNAL:
+            if (kSourceTypes[source_flags & SOURCE_TYPE_MASK].has_target_offset) {
+                size += kOffsetSize[(target_flags & TARGET_OFFSET_32) != 0];
+            }
+            break;
+        case Fixup::IMPORT_ORDINAL:
+            size += (target_flags & IMPORT_ORDINAL_8) ? sizeof(uint8_t)
+                                                       : kOffsetSize[(target_flags & TARGET_OFFSET_32) != 0];
+            break;
+        case Fixup::IMPORT_NAME:
+            size += kOffsetSize[(target_flags & TARGET_OFFSET_32) != 0];
+            break;
+        case Fixup::INTERNAL_ENTRY:
+            break;
+    }
+    if (target_flags & ADDITIVE) {
+        size += kOffsetSize[(target_flags & ADDITIVE_32) != 0];
     }
-    return reloc_flags;
+    return size;
 }
 
-uint8_t Fixup::ThrowOnInvalidObjectIndex(std::istream& is, std::vector<ObjectHeader> objects, uint32_t page_offset) {
-    uint8_t obj_index;
-    ReadLe(is, obj_index);
-    if (obj_index < 1 || obj_index > objects.size()) {
-        throw Error() << "Page at offset 0x" << std::hex << page_offset << ": unexpected object index " << std::dec
-                      << (int)obj_index;
+size_t FixupDecoder::Count(ByteCursor& cursor, size_t end, bool& uses_entry_table) {
+    size_t count = 0;
+    while (cursor.Offset() < end) {
+        cursor.Require(2 * sizeof(uint8_t));
+        uint8_t source_flags = ThrowOnInvalidSourceFlags(cursor.ReadUnchecked<uint8_t>());
+        uint8_t target_flags = ThrowOnInvalidTargetFlags(cursor.ReadUnchecked<uint8_t>());
+        size_t sources = 1;
+        if (source_flags & SOURCE_LIST) {
+            sources = cursor.Read<uint8_t>();
+            cursor.Skip(TargetSize(source_flags, target_flags) + sources * sizeof(int16_t));
+        } else {
+            cursor.Skip(sizeof(int16_t) + TargetSize(source_flags, target_flags));
+        }
+        if ((target_flags & TARGET_TYPE_MASK) == Fixup::INTERNAL_ENTRY) {
+            uses_entry_table = true;
+        }
+        count += sources;
     }
-    return obj_index - 1;
+    return count;
 }
 
-int16_t Fixup::ReadUpToSourceOffset(std::istream& is, size_t& offset, uint8_t& addr_flags, uint8_t& reloc_flags) {
-    addr_flags = ThrowOnInvalidAddressFlags(is);
-    ++offset;
+uint32_t FixupDecoder::ReadTarget(ByteCursor& cursor, uint32_t page_offset, uint8_t source_flags,
+                                  uint8_t target_flags) const {
+    cursor.Require(TargetSize(source_flags, target_flags));
 
-    reloc_flags = ThrowOnInvalidRelocFlags(is);
-    ++offset;
+    uint32_t ordinal = (target_flags & ORDINAL_16) ? cursor.ReadUnchecked<uint16_t>() : cursor.ReadUnchecked<uint8_t>();
+    uint32_t address = 0;
+    bool has_address = true;
+
+    switch (target_flags & TARGET_TYPE_MASK) {
+        case Fixup::INTERNAL:
+            if (ordinal < 1 || ordinal > m_objects.size()) {
+                throw Error() << "Page at offset 0x" << std::hex << page_offset << ": unexpected object index "
+                              << std::dec << ordinal;
+            }
+            if (!kSourceTypes[source_flags & SOURCE_TYPE_MASK].has_target_offset) {
+                address = ordinal;
+                has_address = false;
+            } else {
+                address = m_objects[ordinal - 1].base_address + ((target_flags & TARGET_OFFSET_32)
+                                                                     ? cursor.ReadUnchecked<uint32_t>()
+                                                                     : cursor.ReadUnchecked<uint16_t>());
+            }
+            break;
+        case Fixup::IMPORT_ORDINAL:
+            if (target_flags & IMPORT_ORDINAL_8) {
+                address = cursor.ReadUnchecked<uint8_t>();
+            } else {
+                address = (target_flags & TARGET_OFFSET_32) ? cursor.ReadUnchecked<uint32_t>()
+                                                            : cursor.ReadUnchecked<uint16_t>();
+            }
+            has_address = false;
+            break;
+        case Fixup::IMPORT_NAME:
+            address = (target_flags & TARGET_OFFSET_32) ? cursor.ReadUnchecked<uint32_t>()
+                                                        : cursor.ReadUnchecked<uint16_t>();
+            has_address = false;
+            break;
+        case Fixup::INTERNAL_ENTRY:
+            if (!m_entry_table.Resolve(ordinal, m_objects, address)) {
+                throw Error() << "Page at offset 0x" << std::hex << page_offset << ": unresolved entry ordinal "
+                              << std::dec << ordinal;
+            }
+            break;
+    }
 
-    int16_t src_off;
-    ReadLe(is, src_off);
-    offset += sizeof(int16_t);
-    return src_off;
+    if (target_flags & ADDITIVE) {
+        uint32_t additive =
+            (target_flags & ADDITIVE_32) ? cursor.ReadUnchecked<uint32_t>() : cursor.ReadUnchecked<uint16_t>();
+        if (has_address) {
+            address += additive;
+        }
+    }
+    return address;
 }
 
-uint32_t Fixup::ReadDestOffset(std::istream& is, size_t& offset, std::vector<ObjectHeader> objects,
-                               uint32_t page_offset, uint8_t addr_flags, uint8_t reloc_flags) {
-    if ((reloc_flags & 0x40) != 0) {
-        throw Error() << "16-bit object or module ordinal numbers are not supported";
+size_t FixupDecoder::Decode(ByteCursor& cursor, uint16_t object, uint32_t page_offset, Fixup* out) const {
+    cursor.Require(2 * sizeof(uint8_t));
+    uint8_t source_flags = ThrowOnInvalidSourceFlags(cursor.ReadUnchecked<uint8_t>());
+    uint8_t target_flags = ThrowOnInvalidTargetFlags(cursor.ReadUnchecked<uint8_t>());
+
+    Fixup fixup;
+    fixup.object = object;
+    fixup.source_type = source_flags & SOURCE_TYPE_MASK;
+    fixup.target_type = target_flags & TARGET_TYPE_MASK;
+
+    if ((source_flags & SOURCE_LIST) == 0) {
+        fixup.offset = page_offset + cursor.Read<int16_t>();
+        fixup.address = ReadTarget(cursor, page_offset, source_flags, target_flags);
+        *out = fixup;
+        return 1;
     }
 
-    uint8_t obj_index = ThrowOnInvalidObjectIndex(is, objects, page_offset);
-    ++offset;
-
-    uint32_t dst_off_32;
-    if ((reloc_flags & 0x10) != 0) {
-        ReadLe(is, dst_off_32);
-        offset += sizeof(dst_off_32);
-    } else if ((addr_flags & 0xf) != 0x2) {
-        uint16_t dst_off_16;
-        ReadLe(is, dst_off_16);
-        dst_off_32 = dst_off_16;
-        offset += sizeof(dst_off_16);
-    } else {
-        return obj_index + 1;
+    size_t sources = cursor.Read<uint8_t>();
+    fixup.address = ReadTarget(cursor, page_offset, source_flags, target_flags);
+    cursor.Require(sources * sizeof(int16_t));
+    for (size_t n = 0; n < sources; ++n) {
+        fixup.offset = page_offset + cursor.ReadUnchecked<int16_t>();
+        out[n] = fixup;
     }
-    return objects[obj_index].base_address + dst_off_32;
+    return sources;
 }
-
-Fixup::Fixup(std::istream& is, size_t& offset_, std::vector<ObjectHeader> objects, uint32_t page_offset,
-             uint8_t addr_flags, uint8_t reloc_flags)
-    : offset(page_offset + ReadUpToSourceOffset(is, offset_, addr_flags, reloc_flags)),
-      address(ReadDestOffset(is, offset_, objects, page_offset, addr_flags, reloc_flags)) {}
@@ -19,27 +19,68 @@
 #ifndef LE_DISASM_FIXUP_HPP_
 #define LE_DISASM_FIXUP_HPP_
 
+#include <cstddef>
 #include <cstdint>
-#include <istream>
 #include <vector>
 
+class ByteCursor;
+class EntryTable;
 class ObjectHeader;
 
 class Fixup {
 public:
-    const uint32_t offset;
-    const uint32_t address;
+    enum SourceType {
+        SOURCE_BYTE = 0x0,
+        SOURCE_SELECTOR_16 = 0x2,
+        SOURCE_POINTER_16_16 = 0x3,
+        SOURCE_OFFSET_16 = 0x5,
+        SOURCE_POINTER_16_32 = 0x6,
+        SOURCE_OFFSET_32 = 0x7,
+        SOURCE_RELATIVE_32 = 0x8
+    };
 
-    Fixup(std::istream& is, size_t& offset_, std::vector<ObjectHeader> objects, uint32_t page_offset,
-          uint8_t addr_flags = 0, uint8_t reloc_flags = 0);
+    enum TargetType { INTERNAL = 0, IMPORT_ORDINAL = 1, IMPORT_NAME = 2, INTERNAL_ENTRY = 3 };
+
+    /* Source offset relative to the start of the object. */
+    uint32_t offset;
+    /* Target address, object number for selector fixups, import ordinal or name offset for imports. */
+    uint32_t address;
+    uint16_t object;
+    uint8_t source_type;
+    uint8_t target_type;
+
+    bool IsResolved() const;
+    bool IsRelative() const;
+    size_t SourceSize() const;
+};
+
+class FixupDecoder {
+public:
+    FixupDecoder(const std::vector<ObjectHeader>& objects, const EntryTable& entry_table);
+
+    static size_t Count(ByteCursor& cursor, size_t end, bool& uses_entry_table);
+    size_t Decode(ByteCursor& cursor, uint16_t object, uint32_t page_offset, Fixup* out) const;
 
 private:
-    static uint8_t ThrowOnInvalidAddressFlags(std::istream& is);
-    static uint8_t ThrowOnInvalidRelocFlags(std::istream& is);
-    static uint8_t ThrowOnInvalidObjectIndex(std::istream& is, std::vector<ObjectHeader> objects, uint32_t page_offset);
-    static int16_t ReadUpToSourceOffset(std::istream& is, size_t& offset, uint8_t& addr_flags, uint8_t& reloc_flags);
-    static uint32_t ReadDestOffset(std::istream& is, size_t& offset, std::vector<ObjectHeader> objects,
-                                   uint32_t page_offset, uint8_t addr_flags, uint8_t reloc_flags);
+    enum {
+        SOURCE_TYPE_MASK = 0x0f,
+        SOURCE_LIST = 0x20,
+        TARGET_TYPE_MASK = 0x03,
+        ADDITIVE = 0x04,
+        INTERNAL_CHAINING = 0x08,
+        TARGET_OFFSET_32 = 0x10,
+        ADDITIVE_32 = 0x20,
+        ORDINAL_16 = 0x40,
+        IMPORT_ORDINAL_8 = 0x80
+    };
+
+    const std::vector<ObjectHeader>& m_objects;
+    const EntryTable& m_entry_table;
+
+    static uint8_t ThrowOnInvalidSourceFlags(uint8_t source_flags);
+    static uint8_t ThrowOnInvalidTargetFlags(uint8_t target_flags);
+    static size_t TargetSize(uint8_t source_flags, uint8_t target_flags);
+    uint32_t ReadTarget(ByteCursor& cursor, uint32_t page_offset, uint8_t source_flags, uint8_t target_flags) const;
 };
 
 #endif
@@ -0,0 +1,110 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fixup_index.hpp"
+
+#include <algorithm>
+
+#include "error.hpp"
+
+void SortedKeys::Assign(std::vector<uint32_t>& keys) { m_keys.swap(keys); }
+
+/* Removes all of keys, which may be unsorted and repeated, compacting the set once instead of once per key. */
+void SortedKeys::Erase(std::vector<uint32_t> keys) {
+    if (keys.empty()) {
+        return;
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<uint32_t>::const_iterator removed = keys.begin();
+    std::vector<uint32_t>::iterator out = m_keys.begin();
+    for (std::vector<uint32_t>::const_iterator itr = m_keys.begin(); itr != m_keys.end(); ++itr) {
+        while (removed != keys.end() && *removed < *itr) {
+            ++removed;
+        }
+        if (removed == keys.end() || *removed != *itr) {
+            *out++ = *itr;
+        }
+    }
+    m_keys.erase(out, m_keys.end());
+}
+
+void SortedKeys::Swap(SortedKeys& other) { m_keys.swap(other.m_keys); }
+
+size_t SortedKeys::Size() const { return m_keys.size(); }
+
+bool SortedKeys::Empty() const { return m_keys.empty(); }
+
+uint32_t SortedKeys::operator[](size_t index) const { return m_keys[index]; }
+
+size_t SortedKeys::Find(uint32_t key) const {
+    size_t index = LowerBound(key);
+    return (index < m_keys.size() && m_keys[index] == key) ? index : m_keys.size();
+}
+
+bool SortedKeys::Contains(uint32_t key) const { return Find(key) != m_keys.size(); }
+
+size_t SortedKeys::LowerBound(uint32_t key) const {
+    if (m_keys.empty()) {
+        return 0;
+    }
+    const uint32_t* base = &m_keys.front();
+    for (size_t count = m_keys.size(); count > 1;) {
+        size_t half = count / 2;
+        __builtin_prefetch(base + half / 2);
+        __builtin_prefetch(base + half + half / 2);
+        base = (base[half] < key) ? base + half : base;
+        count -= half;
+    }
+    return (base - &m_keys.front()) + (*base < key);
+}
+
+size_t SortedKeys::UpperBound(uint32_t key) const {
+    if (m_keys.empty()) {
+        return 0;
+    }
+    const uint32_t* base = &m_keys.front();
+    for (size_t count = m_keys.size(); count > 1;) {
+        size_t half = count / 2;
+        __builtin_prefetch(base + half / 2);
+        __builtin_prefetch(base + half + half / 2);
+        base = (base[half] <= key) ? base + half : base;
+        count -= half;
+    }
+    return (base - &m_keys.front()) + (*base <= key);
+}
+
+void FixupIndex::Assign(std::vector<uint32_t>& offsets, std::vector<uint32_t>& addresses) {
+    if (offsets.size() != addresses.size()) {
+        throw Error() << "Fixup index size mismatch";
+    }
+    m_addresses.swap(addresses);
+    m_offsets.Assign(offsets);
+}
+
+size_t FixupIndex::Size() const { return m_offsets.Size(); }
+
+bool FixupIndex::Empty() const { return m_offsets.Empty(); }
+
+uint32_t FixupIndex::Offset(size_t index) const { return m_offsets[index]; }
+
+uint32_t FixupIndex::Address(size_t index) const { return m_addresses[index]; }
+
+size_t FixupIndex::Find(uint32_t offset) const { return m_offsets.Find(offset); }
+
+bool FixupIndex::Contains(uint32_t offset) const { return m_offsets.Contains(offset); }
+
+size_t FixupIndex::UpperBound(uint32_t offset) const { return m_offsets.UpperBound(offset); }
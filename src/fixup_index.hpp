@@ -0,0 +1,62 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LE_DISASM_FIXUP_INDEX_HPP_
+#define LE_DISASM_FIXUP_INDEX_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Sorted set of unique 32 bit keys searched with a branch free binary search that prefetches both possible next
+ * probes, so lookups in large sets overlap their cache misses instead of stalling on every mispredicted branch. */
+class SortedKeys {
+public:
+    void Assign(std::vector<uint32_t>& keys);
+    void Erase(std::vector<uint32_t> keys);
+    void Swap(SortedKeys& other);
+
+    size_t Size() const;
+    bool Empty() const;
+    uint32_t operator[](size_t index) const;
+    size_t Find(uint32_t key) const;
+    bool Contains(uint32_t key) const;
+    size_t LowerBound(uint32_t key) const;
+    size_t UpperBound(uint32_t key) const;
+
+private:
+    std::vector<uint32_t> m_keys;
+};
+
+/* Fixups of a single object keyed by source offset, stored as parallel arrays. */
+class FixupIndex {
+public:
+    void Assign(std::vector<uint32_t>& offsets, std::vector<uint32_t>& addresses);
+
+    size_t Size() const;
+    bool Empty() const;
+    uint32_t Offset(size_t index) const;
+    uint32_t Address(size_t index) const;
+    size_t Find(uint32_t offset) const;
+    bool Contains(uint32_t offset) const;
+    size_t UpperBound(uint32_t offset) const;
+
+private:
+    SortedKeys m_offsets;
+    std::vector<uint32_t> m_addresses;
+};
+
+#endif
@@ -23,85 +23,86 @@
 #include "error.hpp"
 #include "little_endian.hpp"
 
-void Header::ThrowOnInvalidSignature(std::istream& is, uint32_t& header_offset) {
+void Header::ThrowOnInvalidSignature(ByteCursor& cursor, uint32_t& header_offset) {
     char id[3] = {"??"};
-    is.seekg(0);
-    is.read(id, 2);
+    cursor.Seek(0).Require(2);
+    id[0] = cursor.ReadUnchecked<uint8_t>();
+    id[1] = cursor.ReadUnchecked<uint8_t>();
     if (strcmp(id, "MZ") && strcmp(id, "LE") && strcmp(id, "LX")) {
         throw Error() << "Invalid MZ signature: " << id;
     } else if (!strcmp(id, "MZ")) {
-        is.seekg(0x18);
         uint8_t byte;
-        ReadLe(is, byte);
+        cursor.Seek(0x18).Read(byte);
         if (byte < 0x40) {
             throw Error() << "Not a LE executable, at offset 0x18: expected 0x40 or more, got 0x" << std::hex << byte;
         }
-        is.seekg(0x3c);
-        ReadLe(is, header_offset);
-        is.seekg(header_offset);
-        is.read(id, 2);
+        cursor.Seek(0x3c).Read(header_offset);
+        cursor.Seek(header_offset).Require(2);
+        id[0] = cursor.ReadUnchecked<uint8_t>();
+        id[1] = cursor.ReadUnchecked<uint8_t>();
         if (strcmp(id, "LE")) {
             throw Error() << "Invalid LE signature: " << id;
         }
     }
 }
 
-Header::Header(std::istream& is, uint32_t& header_offset) {
-    ThrowOnInvalidSignature(is, header_offset);
-    ReadLe(is, byte_order);
+Header::Header(ByteCursor& cursor, uint32_t& header_offset) {
+    ThrowOnInvalidSignature(cursor, header_offset);
+    cursor.Require(RECORD_SIZE);
+    cursor.ReadUnchecked(byte_order);
     if (byte_order != 0) {
         throw Error() << "Only LITTLE_ENDIAN byte order supported: " << byte_order;
     }
-    ReadLe(is, word_order);
+    cursor.ReadUnchecked(word_order);
     if (word_order != 0) {
         throw Error() << "Only LITTLE_ENDIAN word order supported: " << word_order;
     }
-    ReadLe(is, format_version);
+    cursor.ReadUnchecked(format_version);
     if (format_version > 0) {
         throw Error() << "Unknown LE format version: " << format_version;
     }
-    ReadLe(is, cpu_type);
-    ReadLe(is, os_type);
-    ReadLe(is, module_version);
-    ReadLe(is, module_flags);
-    ReadLe(is, page_count);
-    ReadLe(is, eip_object_index);
-    ReadLe(is, eip_offset);
-    ReadLe(is, esp_object_index);
-    ReadLe(is, esp_offset);
-    ReadLe(is, page_size);
-    ReadLe(is, last_page_size);
-    ReadLe(is, fixup_section_size);
-    ReadLe(is, fixup_section_check_sum);
-    ReadLe(is, loader_section_size);
-    ReadLe(is, loader_section_check_sum);
-    ReadLe(is, object_table_offset);
-    ReadLe(is, object_count);
-    ReadLe(is, object_page_table_offset);
-    ReadLe(is, object_iterated_pages_offset);
-    ReadLe(is, resource_table_offset);
-    ReadLe(is, resource_entry_count);
-    ReadLe(is, resident_name_table_offset);
-    ReadLe(is, entry_table_offset);
-    ReadLe(is, module_directives_offset);
-    ReadLe(is, module_directives_count);
-    ReadLe(is, fixup_page_table_offset);
-    ReadLe(is, fixup_record_table_offset);
-    ReadLe(is, import_module_name_table_offset);
-    ReadLe(is, import_module_name_entry_count);
-    ReadLe(is, import_procedure_name_table_offset);
-    ReadLe(is, per_page_check_sum_table_offset);
-    ReadLe(is, data_pages_offset);
-    ReadLe(is, preload_pages_count);
-    ReadLe(is, non_resident_name_table_offset);
-    ReadLe(is, non_resident_name_entry_count);
-    ReadLe(is, non_resident_name_table_check_sum);
-    ReadLe(is, auto_data_segment_object_index);
-    ReadLe(is, debug_info_offset);
-    ReadLe(is, debug_info_size);
-    ReadLe(is, instance_pages_count);
-    ReadLe(is, instance_pages_demand_count);
-    ReadLe(is, heap_size);
+    cursor.ReadUnchecked(cpu_type);
+    cursor.ReadUnchecked(os_type);
+    cursor.ReadUnchecked(module_version);
+    cursor.ReadUnchecked(module_flags);
+    cursor.ReadUnchecked(page_count);
+    cursor.ReadUnchecked(eip_object_index);
+    cursor.ReadUnchecked(eip_offset);
+    cursor.ReadUnchecked(esp_object_index);
+    cursor.ReadUnchecked(esp_offset);
+    cursor.ReadUnchecked(page_size);
+    cursor.ReadUnchecked(last_page_size);
+    cursor.ReadUnchecked(fixup_section_size);
+    cursor.ReadUnchecked(fixup_section_check_sum);
+    cursor.ReadUnchecked(loader_section_size);
+    cursor.ReadUnchecked(loader_section_check_sum);
+    cursor.ReadUnchecked(object_table_offset);
+    cursor.ReadUnchecked(object_count);
+    cursor.ReadUnchecked(object_page_table_offset);
+    cursor.ReadUnchecked(object_iterated_pages_offset);
+    cursor.ReadUnchecked(resource_table_offset);
+    cursor.ReadUnchecked(resource_entry_count);
+    cursor.ReadUnchecked(resident_name_table_offset);
+    cursor.ReadUnchecked(entry_table_offset);
+    cursor.ReadUnchecked(module_directives_offset);
+    cursor.ReadUnchecked(module_directives_count);
+    cursor.ReadUnchecked(fixup_page_table_offset);
+    cursor.ReadUnchecked(fixup_record_table_offset);
+    cursor.ReadUnchecked(import_module_name_table_offset);
+    cursor.ReadUnchecked(import_module_name_entry_count);
+    cursor.ReadUnchecked(import_procedure_name_table_offset);
+    cursor.ReadUnchecked(per_page_check_sum_table_offset);
+    cursor.ReadUnchecked(data_pages_offset);
+    cursor.ReadUnchecked(preload_pages_count);
+    cursor.ReadUnchecked(non_resident_name_table_offset);
+    cursor.ReadUnchecked(non_resident_name_entry_count);
+    cursor.ReadUnchecked(non_resident_name_table_check_sum);
+    cursor.ReadUnchecked(auto_data_segment_object_index);
+    cursor.ReadUnchecked(debug_info_offset);
+    cursor.ReadUnchecked(debug_info_size);
+    cursor.ReadUnchecked(instance_pages_count);
+    cursor.ReadUnchecked(instance_pages_demand_count);
+    cursor.ReadUnchecked(heap_size);
     --eip_object_index;
     --esp_object_index;
 }
@@ -20,7 +20,8 @@
 #define LE_DISASM_HEADER_HPP_
 
 #include <cstdint>
-#include <istream>
+
+class ByteCursor;
 
 class Header {
 public:
@@ -70,10 +71,12 @@ public:
     uint32_t instance_pages_demand_count;
     uint32_t heap_size;
 
-    Header(std::istream& is, uint32_t& header_offset);
+    Header(ByteCursor& cursor, uint32_t& header_offset);
 
 private:
-    void ThrowOnInvalidSignature(std::istream& is, uint32_t& header_offset);
+    enum { RECORD_SIZE = 2 * sizeof(uint8_t) + sizeof(uint32_t) + 2 * sizeof(uint16_t) + 40 * sizeof(uint32_t) };
+
+    void ThrowOnInvalidSignature(ByteCursor& cursor, uint32_t& header_offset);
 };
 
 #endif
@@ -19,60 +19,197 @@
 #include "image.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 
 #include "error.hpp"
 #include "linear_executable.hpp"
 #include "little_endian.hpp"
+#include "mapped_file.hpp"
 
 const ImageObject& Image::ObjectAt(uint32_t address) const {
-    for (size_t n = 0; n < objects.size(); ++n) {
-        const ImageObject& obj = objects[n];
-        if (obj.BaseAddress() <= address and address < obj.BaseAddress() + obj.Size()) {
-            return obj;
-        }
+    const ImageObject* obj = FindObject(address);
+    if (obj) {
+        return *obj;
     }
     throw Error() << "BUG: address out of image range: 0x" << std::setfill('0') << std::setw(6) << std::hex
                   << std::noshowbase << address;
 }
 
-bool Image::IsValidAddress(const uint32_t address) {
+/* Returns the object containing address or NULL, the page directory resolves all but pages shared by objects. */
+const ImageObject* Image::FindObject(uint32_t address) const {
+    uint32_t page = (address >> PAGE_SHIFT) - m_first_page;
+    if (page < m_page_objects.size()) {
+        uint16_t n = m_page_objects[page];
+        if (n == NO_OBJECT) {
+            return NULL;
+        }
+        if (n != SHARED_PAGE) {
+            const ImageObject& obj = objects[n];
+            return address - obj.BaseAddress() < obj.Size() ? &obj : NULL;
+        }
+    } else if (!m_page_objects.empty()) {
+        return NULL;
+    }
+
     for (size_t n = 0; n < objects.size(); ++n) {
         const ImageObject& obj = objects[n];
         if (obj.BaseAddress() <= address and address < obj.BaseAddress() + obj.Size()) {
-            return true;
+            return &obj;
         }
     }
-    return false;
+    return NULL;
 }
 
-void Image::LoadObjectData(std::istream& is, LinearExecutable& lx, std::vector<uint8_t>& data, Header& hdr,
-                           ObjectHeader& ohdr) {
+bool Image::IsValidAddress(const uint32_t address) const { return FindObject(address) != NULL; }
+
+void Image::IndexObjects() {
+    m_page_objects.clear();
+    m_first_page = 0;
+    if (objects.empty() || objects.size() >= SHARED_PAGE) {
+        return;
+    }
+
+    uint64_t first_page = UINT32_MAX, end_page = 0;
+    for (size_t n = 0; n < objects.size(); ++n) {
+        uint64_t end_address = (uint64_t)objects[n].BaseAddress() + objects[n].Size();
+        first_page = std::min<uint64_t>(first_page, objects[n].BaseAddress() >> PAGE_SHIFT);
+        end_page = std::max<uint64_t>(end_page, (end_address + (1 << PAGE_SHIFT) - 1) >> PAGE_SHIFT);
+    }
+    if (end_page <= first_page || end_page - first_page > MAX_PAGES) {
+        return;
+    }
+
+    m_first_page = first_page;
+    m_page_objects.assign(end_page - first_page, NO_OBJECT);
+    for (size_t n = 0; n < objects.size(); ++n) {
+        if (objects[n].Size() == 0) {
+            continue;
+        }
+        uint64_t last_address = (uint64_t)objects[n].BaseAddress() + objects[n].Size() - 1;
+        for (uint64_t page = objects[n].BaseAddress() >> PAGE_SHIFT; page <= last_address >> PAGE_SHIFT; ++page) {
+            uint16_t& entry = m_page_objects[page - first_page];
+            entry = entry == NO_OBJECT ? (uint16_t)n : (uint16_t)SHARED_PAGE;
+        }
+    }
+}
+
+/* Returns the number of bytes loaded from the file, the rest of the object is left zero filled. */
+size_t Image::LoadObjectData(const MappedFile& file, LinearExecutable& lx, uint8_t* data, Header& hdr,
+                             ObjectHeader& ohdr) {
     size_t data_off = 0, page_end = std::min<size_t>(ohdr.first_page_index + ohdr.page_count, hdr.page_count);
     for (size_t page_idx = ohdr.first_page_index; page_idx < page_end; ++page_idx) {
         size_t size = std::min<size_t>(ohdr.virtual_size - data_off,
                                        (page_idx + 1 < hdr.page_count) ? hdr.page_size : hdr.last_page_size);
-        is.seekg(lx.OffsetOfPageInFile(page_idx));
-        if (!is.read((char*)&data.front() + data_off, size).good()) {
-            throw Error() << "EOF";
+        memcpy(data + data_off, file.GetSpan(lx.OffsetOfPageInFile(page_idx), size), size);
+        data_off += size;
+    }
+    return data_off;
+}
+
+/* Objects without fixups whose pages are stored back to back in the file and cover the whole virtual size can be
+ * referenced straight from the file mapping instead of being copied into a private buffer.
+ */
+const uint8_t* Image::FindObjectDataInPlace(const MappedFile& file, LinearExecutable& lx, Header& hdr,
+                                            ObjectHeader& ohdr) {
+    size_t data_off = 0, page_end = std::min<size_t>(ohdr.first_page_index + ohdr.page_count, hdr.page_count);
+    size_t file_off = lx.OffsetOfPageInFile(ohdr.first_page_index);
+    for (size_t page_idx = ohdr.first_page_index; page_idx < page_end && data_off < ohdr.virtual_size; ++page_idx) {
+        size_t size = std::min<size_t>(ohdr.virtual_size - data_off,
+                                       (page_idx + 1 < hdr.page_count) ? hdr.page_size : hdr.last_page_size);
+        if (lx.OffsetOfPageInFile(page_idx) != file_off + data_off) {
+            return NULL;
         }
         data_off += size;
     }
+    if (data_off != ohdr.virtual_size || data_off == 0) {
+        return NULL;
+    }
+    return file.GetSpan(file_off, data_off);
+}
+
+/* Number of the object containing address, the loader gives every object a selector of its own. Pointers just past
+ * the end of an object resolve to it as well, unless another object starts there. Zero if no object matches.
+ */
+static uint16_t ObjectNumberAt(const LinearExecutable& lx, uint32_t address) {
+    uint16_t end_match = 0;
+    for (size_t n = 0; n < lx.objects.size(); ++n) {
+        const ObjectHeader& ohdr = lx.objects[n];
+        if (ohdr.base_address <= address) {
+            if (address - ohdr.base_address < ohdr.virtual_size) {
+                return n + 1;
+            }
+            if (address - ohdr.base_address == ohdr.virtual_size && end_match == 0) {
+                end_match = n + 1;
+            }
+        }
+    }
+    return end_match;
+}
+
+/* Offset of address within the segment of its object. 32 bit objects share a flat segment based at zero, while 16 bit
+ * objects are segments of their own.
+ */
+static uint32_t SegmentOffset(const LinearExecutable& lx, uint32_t address) {
+    uint16_t number = ObjectNumberAt(lx, address);
+    if (number == 0 || lx.objects[number - 1].Is32BitObject()) {
+        return address;
+    }
+    return address - lx.objects[number - 1].base_address;
+}
+
+static uint16_t Selector(const LinearExecutable& lx, const Fixup& fixup) {
+    if (fixup.source_type == Fixup::SOURCE_SELECTOR_16 && fixup.target_type == Fixup::INTERNAL) {
+        /* Internal selector fixups carry the object number instead of an address. */
+        return fixup.address;
+    }
+    return ObjectNumberAt(lx, fixup.address);
 }
 
-void Image::ApplyFixups(std::map<uint32_t, uint32_t>& fixups, std::vector<uint8_t>& data) {
-    for (std::map<uint32_t, uint32_t>::iterator itr = fixups.begin(); itr != fixups.end(); ++itr) {
-        if (itr->first + 4 >= data.size()) {
+/* Patches each resolved fixup with exactly as many bytes as its source type covers. Returns the end offset of the last
+ * byte written by any fixup.
+ */
+size_t Image::ApplyFixups(LinearExecutable& lx, size_t oi, uint32_t base_address, uint8_t* data, size_t size) {
+    size_t end = 0;
+    for (size_t n = lx.fixup_record_ranges[oi]; n < lx.fixup_record_ranges[oi + 1]; ++n) {
+        const Fixup& fixup = lx.fixup_records[n];
+        if (!fixup.IsResolved()) {
+            continue;
+        }
+        size_t source_size = fixup.SourceSize();
+        if (fixup.offset >= size || size - fixup.offset < source_size) {
             throw Error() << "Fixup points outside object boundaries";
         }
-        void* ptr = &data.front() + itr->first;
-        if (itr->second < 256) {
-            WriteLe<uint16_t>(ptr, itr->second);
-        } else {
-            WriteLe<uint32_t>(ptr, itr->second);
+        uint8_t* ptr = data + fixup.offset;
+        switch (fixup.source_type) {
+            case Fixup::SOURCE_BYTE:
+                *ptr = SegmentOffset(lx, fixup.address);
+                break;
+            case Fixup::SOURCE_SELECTOR_16:
+                WriteLe<uint16_t>(ptr, Selector(lx, fixup));
+                break;
+            case Fixup::SOURCE_POINTER_16_16:
+                WriteLe<uint16_t>(ptr, SegmentOffset(lx, fixup.address));
+                WriteLe<uint16_t>(ptr + sizeof(uint16_t), Selector(lx, fixup));
+                break;
+            case Fixup::SOURCE_OFFSET_16:
+                WriteLe<uint16_t>(ptr, SegmentOffset(lx, fixup.address));
+                break;
+            case Fixup::SOURCE_POINTER_16_32:
+                WriteLe<uint32_t>(ptr, SegmentOffset(lx, fixup.address));
+                WriteLe<uint16_t>(ptr + sizeof(uint32_t), Selector(lx, fixup));
+                break;
+            case Fixup::SOURCE_RELATIVE_32:
+                WriteLe<uint32_t>(ptr, fixup.address - (base_address + fixup.offset + sizeof(uint32_t)));
+                break;
+            default:
+                WriteLe<uint32_t>(ptr, fixup.address);
+                break;
         }
+        end = std::max<size_t>(end, fixup.offset + source_size);
     }
+    return end;
 }
 
 bool Image::OutputFlatMemoryDump(std::string& path, bool trim_padding) {
@@ -100,15 +237,26 @@ bool Image::OutputFlatMemoryDump(std::string& path, bool trim_padding) {
     return false;
 }
 
-Image::Image(std::istream& is, LinearExecutable& lx) {
-    std::vector<uint8_t> data;
+Image::Image(const MappedFile& file, LinearExecutable& lx) {
     objects.resize(lx.objects.size());
     for (size_t oi = 0; oi < lx.objects.size(); ++oi) {
         ObjectHeader& ohdr = lx.objects[oi];
-        data.clear();
-        data.resize(ohdr.virtual_size);
-        LoadObjectData(is, lx, data, lx.header, ohdr);
-        ApplyFixups(lx.fixups[oi], data);
-        objects[oi].Init(oi, ohdr.base_address, ohdr.IsExecutable(), ohdr.Is32BitObject(), data);
+        if (lx.fixup_record_ranges[oi] == lx.fixup_record_ranges[oi + 1]) {
+            const uint8_t* in_place = FindObjectDataInPlace(file, lx, lx.header, ohdr);
+            if (in_place) {
+                objects[oi].Init(oi, ohdr.base_address, ohdr.IsExecutable(), ohdr.Is32BitObject(), in_place,
+                                 ohdr.virtual_size);
+                objects[oi].SetRelocations(lx.fixups[oi]);
+                continue;
+            }
+        }
+        /* Pages are copied straight into the object's own storage and patched there. */
+        uint8_t* data = objects[oi].Init(oi, ohdr.base_address, ohdr.IsExecutable(), ohdr.Is32BitObject(),
+                                         ohdr.virtual_size);
+        size_t backed_size = data ? LoadObjectData(file, lx, data, lx.header, ohdr) : 0;
+        backed_size = std::max(backed_size, ApplyFixups(lx, oi, ohdr.base_address, data, ohdr.virtual_size));
+        objects[oi].SetBackedSize(backed_size);
+        objects[oi].SetRelocations(lx.fixups[oi]);
     }
+    IndexObjects();
 }
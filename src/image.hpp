@@ -20,7 +20,6 @@
 #define LE_DISASM_IMAGE_HPP_
 
 #include <cstdint>
-#include <istream>
 #include <map>
 #include <string>
 #include <vector>
@@ -30,21 +29,31 @@
 class LinearExecutable;
 class Header;
 class ObjectHeader;
+class MappedFile;
 
 class Image {
 public:
     std::vector<ImageObject> objects;
 
-    Image(std::istream& is, LinearExecutable& lx);
+    Image(const MappedFile& file, LinearExecutable& lx);
 
     const ImageObject& ObjectAt(uint32_t address) const;
-    bool IsValidAddress(const uint32_t address);
+    const ImageObject* FindObject(uint32_t address) const;
+    bool IsValidAddress(const uint32_t address) const;
     bool OutputFlatMemoryDump(std::string& path, bool trim_padding = false);
 
 private:
-    void LoadObjectData(std::istream& is, LinearExecutable& lx, std::vector<uint8_t>& data, Header& hdr,
-                        ObjectHeader& ohdr);
-    void ApplyFixups(std::map<uint32_t, uint32_t>& fixups, std::vector<uint8_t>& data);
+    enum { PAGE_SHIFT = 12, MAX_PAGES = 0x10000, NO_OBJECT = 0xffff, SHARED_PAGE = 0xfffe };
+
+    /* Index of the object on each page from m_first_page on, empty if the objects span too many pages. */
+    std::vector<uint16_t> m_page_objects;
+    uint32_t m_first_page;
+
+    void IndexObjects();
+    size_t LoadObjectData(const MappedFile& file, LinearExecutable& lx, uint8_t* data, Header& hdr, ObjectHeader& ohdr);
+    const uint8_t* FindObjectDataInPlace(const MappedFile& file, LinearExecutable& lx, Header& hdr,
+                                         ObjectHeader& ohdr);
+    size_t ApplyFixups(LinearExecutable& lx, size_t oi, uint32_t base_address, uint8_t* data, size_t size);
 };
 
 #endif
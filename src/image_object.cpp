@@ -18,20 +18,124 @@
 
 #include "image_object.hpp"
 
-void ImageObject::Init(size_t index, uint32_t base_address, bool executable, bool bitness,
-                       const std::vector<uint8_t>& data) {
+#include <algorithm>
+
+#include "fixup_index.hpp"
+#include "sparse_buffer.hpp"
+
+ImageObject::ImageObject()
+    : m_index(0), m_base_address(0), m_executable(false), m_bitness(BITNESS_32BIT),
+      m_bytes(NULL),
+      m_size(0),
+      m_backed_size(0) {}
+
+ImageObject::ImageObject(const ImageObject& other) { *this = other; }
+
+ImageObject& ImageObject::operator=(const ImageObject& other) {
+    m_index = other.m_index;
+    m_base_address = other.m_base_address;
+    m_executable = other.m_executable;
+    m_bitness = other.m_bitness;
+    m_data = other.m_data;
+    m_sparse_data = other.m_sparse_data;
+    m_bytes = m_data.empty() ? other.m_bytes : &m_data.front();
+    m_size = other.m_size;
+    m_backed_size = other.m_backed_size;
+    m_relocations = other.m_relocations;
+    return *this;
+}
+
+/* The object owns zero filled storage of the given size, the returned pointer is used to load and patch it. The
+ * backed size starts at zero and has to be set once the data is loaded.
+ */
+uint8_t* ImageObject::Init(size_t index, uint32_t base_address, bool executable, bool bitness, uint32_t size) {
+    m_index = index;
+    m_base_address = base_address;
+    m_executable = executable;
+    m_bitness = bitness ? BITNESS_32BIT : BITNESS_16BIT;
+    m_data.clear();
+    m_sparse_data.reset();
+    m_size = size;
+    m_backed_size = 0;
+    if (size >= SPARSE_THRESHOLD) {
+        m_sparse_data.reset(new SparseBuffer());
+        if (m_sparse_data->Allocate(size)) {
+            m_bytes = m_sparse_data->Data();
+            return m_sparse_data->Data();
+        }
+        m_sparse_data.reset();
+    }
+    m_data.assign(size, 0);
+    m_bytes = m_data.empty() ? NULL : &m_data.front();
+    return m_data.empty() ? NULL : &m_data.front();
+}
+
+/* The object references externally owned bytes, e.g. a file mapping, which must outlive the object. */
+void ImageObject::Init(size_t index, uint32_t base_address, bool executable, bool bitness, const uint8_t* data,
+                       uint32_t size) {
     m_index = index;
     m_base_address = base_address;
     m_executable = executable;
     m_bitness = bitness ? BITNESS_32BIT : BITNESS_16BIT;
-    m_data = data;
+    m_data.clear();
+    m_sparse_data.reset();
+    m_bytes = data;
+    m_size = size;
+    m_backed_size = size;
+}
+
+/* The bitmap only covers the backed bytes, fixups patch their source so it never lies in the zero filled tail. */
+void ImageObject::SetRelocations(const FixupIndex& fixups) {
+    size_t size = m_backed_size;
+    if (!fixups.Empty()) {
+        size = std::max<size_t>(size, std::min<size_t>(fixups.Offset(fixups.Size() - 1) + 1, m_size));
+    }
+    m_relocations.assign((size + 63) / 64, 0);
+    for (size_t n = 0; n < fixups.Size(); ++n) {
+        uint32_t offset = fixups.Offset(n);
+        if (offset < size) {
+            m_relocations[offset / 64] |= 1ULL << (offset % 64);
+        }
+    }
+}
+
+bool ImageObject::IsRelocation(uint32_t address) const {
+    uint32_t offset = address - m_base_address;
+    if (offset / 64 >= m_relocations.size()) {
+        return false;
+    }
+    return (m_relocations[offset / 64] >> (offset % 64)) & 1;
+}
+
+/* Returns the address of the first fixup at or after address, or the end address of the object if there is none. */
+uint32_t ImageObject::NextRelocation(uint32_t address) const {
+    uint32_t offset = address - m_base_address;
+    if (offset / 64 >= m_relocations.size()) {
+        return m_base_address + m_size;
+    }
+    size_t word = offset / 64;
+    uint64_t bits = m_relocations[word] & (~0ULL << (offset % 64));
+    while (bits == 0) {
+        if (++word == m_relocations.size()) {
+            return m_base_address + m_size;
+        }
+        bits = m_relocations[word];
+    }
+    return m_base_address + word * 64 + __builtin_ctzll(bits);
+}
+
+void ImageObject::SetBackedSize(uint32_t size) { m_backed_size = std::min(size, m_size); }
+
+/* Returns whether any byte of the range may be non-zero. */
+bool ImageObject::IsBacked(uint32_t address, size_t size) const {
+    return size != 0 && address - m_base_address < m_backed_size;
 }
 
-const uint8_t* ImageObject::GetDataAt(uint32_t address) const { return (&m_data.front() + address - m_base_address); }
+const uint8_t* ImageObject::GetDataAt(uint32_t address) const { return (m_bytes + address - m_base_address); }
 
 uint32_t ImageObject::BaseAddress() const { return m_base_address; }
 
-uint32_t ImageObject::Size() const { return m_data.size(); }
+uint32_t ImageObject::Size() const { return m_size; }
 
 ::Bitness ImageObject::GetBitness() const { return m_bitness; }
 
@@ -20,13 +20,29 @@
 #define LE_DISASM_IMAGE_OBJECT_HPP_
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "type.hpp"
 
+class FixupIndex;
+class SparseBuffer;
+
 class ImageObject {
 public:
-    void Init(size_t index, uint32_t base_address, bool executable, bool bitness, const std::vector<uint8_t>& data);
+    ImageObject();
+    ImageObject(const ImageObject& other);
+    ImageObject& operator=(const ImageObject& other);
+
+    uint8_t* Init(size_t index, uint32_t base_address, bool executable, bool bitness, uint32_t size);
+    void Init(size_t index, uint32_t base_address, bool executable, bool bitness, const uint8_t* data, uint32_t size);
+
+    void SetRelocations(const FixupIndex& fixups);
+    bool IsRelocation(uint32_t address) const;
+    uint32_t NextRelocation(uint32_t address) const;
+
+    void SetBackedSize(uint32_t size);
+    bool IsBacked(uint32_t address, size_t size) const;
 
     const uint8_t* GetDataAt(uint32_t address) const;
     uint32_t BaseAddress() const;
@@ -36,11 +52,21 @@ public:
     size_t Index() const;
 
 private:
+    enum { SPARSE_THRESHOLD = 0x10000 };
+
     size_t m_index;
     uint32_t m_base_address;
     bool m_executable;
     ::Bitness m_bitness;
     std::vector<uint8_t> m_data;
+    /* Large objects own anonymous memory instead of m_data, copies of the object share it. */
+    std::shared_ptr<SparseBuffer> m_sparse_data;
+    const uint8_t* m_bytes;
+    uint32_t m_size;
+    /* Bytes past this offset were neither loaded from the file nor patched and read as zero. */
+    uint32_t m_backed_size;
+    /* One bit per byte offset, set where an absolute fixup starts. */
+    std::vector<uint64_t> m_relocations;
 };
 
 #endif
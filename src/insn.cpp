@@ -23,6 +23,7 @@
 #include <cassert>
 #include <cctype>
 #include <cstdarg>
+#include <cstdlib>
 #include <cstring>
 
 #include "error.hpp"
@@ -39,41 +40,146 @@ Insn::Insn(const ImageObject* const image_object_pointer) : m_image_object_point
 
 uint32_t Insn::BaseAddress() { return m_image_object_pointer->BaseAddress(); }
 
-int Insn::LowerCasedSpaceTrimmed(int ret, char* end) {
-    for (text = &m_string[0]; text < &m_string[text_length] + ret && isspace(*text); ++text);
-    for (char* i = text; i <= end; *i = tolower(*i), ++i);
+const ImageObject* Insn::ImageObjectPointer() const { return m_image_object_pointer; }
+
+/* The text before from was lower cased by earlier calls, only the appended bytes are converted. The conversion is
+ * branch free ASCII so that the compiler can vectorize it, the tool never switches away from the "C" locale.
+ */
+int Insn::LowerCasedSpaceTrimmed(int ret, char* from, char* end) {
+    for (text = &m_string[0]; text < from + ret && isspace(*text); ++text);
+    for (char* i = from < text ? text : from; i <= end; ++i) {
+        *i += ((unsigned char)(*i - 'A') < 26) << 5;
+    }
     *(end + 1) = 0;
     text_length = end + 1 - text;
     return ret;
 }
 
+/* Appends a token printed by libopcodes to the text. Most tokens are printed with a plain "%s" format, those are
+ * copied without going through vsnprintf.
+ */
+int Insn::AppendText(enum disassembler_style style, const char* fmt, va_list list) {
+    char* from = &m_string[text_length];
+    size_t available = sizeof(m_string) - 1 - text_length;
+    int ret;
+
+    if (fmt[0] == '%' && fmt[1] == 's' && fmt[2] == 0) {
+        const char* token = va_arg(list, const char*);
+        size_t length = strlen(token);
+        if (available > 0) {
+            size_t copied = length < available ? length : available - 1;
+            memcpy(from, token, copied);
+            from[copied] = 0;
+        }
+        ret = length;
+    } else {
+        ret = vsnprintf(from, available, fmt, list);
+    }
+
+    type = MISC;
+
+    ret = LowerCasedSpaceTrimmed(ret, from, from + ret - 1);
+    RecordOperands(from, style);
+    return ret;
+}
+
+/* Records the hexadecimal numbers of the text printed at from, operands recorded earlier at or behind from were
+ * overwritten and are dropped. libopcodes prints every number with a single callback, so a number never spans two
+ * calls.
+ */
+void Insn::RecordOperands(const char* from, enum disassembler_style style) {
+    if (from < text) {
+        from = text;
+    }
+    size_t start = from - text;
+    while (operand_count > 0 && operands[operand_count - 1].offset >= start) {
+        --operand_count;
+    }
+
+    for (const char* number = strstr(from, "0x"); number; number = strstr(number, "0x")) {
+        size_t offset = number - text;
+        if (offset + 2 >= text_length) {
+            break;
+        }
+
+        uint32_t value = 0;
+        const char* end = number + 2;
+        for (; isxdigit(*end); ++end) {
+            value = (value << 4) | (isdigit(*end) ? *end - '0' : *end - 'a' + 10);
+        }
+
+        if (operand_count < MAX_OPERANDS) {
+            Operand& operand = operands[operand_count++];
+            if (style == dis_style_immediate || (offset > 0 && text[offset - 1] == '$')) {
+                operand.kind = Operand::IMMEDIATE;
+            } else if (style == dis_style_address_offset || *end == '(') {
+                operand.kind = Operand::DISPLACEMENT;
+            } else {
+                operand.kind = Operand::ADDRESS;
+            }
+            operand.value = value;
+            operand.offset = offset;
+            operand.length = end - number;
+        }
+        number = end;
+    }
+}
+
+/* Branch targets are printed through the print address callback, the number it printed last is the target. */
+void Insn::MarkLastOperandAsTarget() {
+    if (operand_count > 0) {
+        operands[operand_count - 1].kind = Operand::TARGET;
+    }
+}
+
+const Insn::Operand* Insn::OperandAt(size_t offset) const {
+    for (size_t i = 0; i < operand_count; ++i) {
+        if (operands[i].offset == offset) {
+            return &operands[i];
+        }
+    }
+    return NULL;
+}
+
 int Insn::CallbackResetTypeAndText(void* stream, const char* fmt, ...) {
     va_list list;
-    Insn* insn = (Insn*)stream;
     va_start(list, fmt);
-    int ret = vsnprintf(&insn->m_string[insn->text_length], sizeof(insn->m_string) - 1 - insn->text_length, fmt, list);
+    int ret = ((Insn*)stream)->AppendText(dis_style_text, fmt, list);
     va_end(list);
-    insn->type = MISC;
-
-    return insn->LowerCasedSpaceTrimmed(ret, &insn->m_string[insn->text_length] + ret - 1);
+    return ret;
 }
 
 int Insn::CallbackResetTypeAndText(void* stream, enum disassembler_style style, const char* fmt, ...) {
     va_list list;
-    Insn* insn = (Insn*)stream;
     va_start(list, fmt);
-    int ret = vsnprintf(&insn->m_string[insn->text_length], sizeof(insn->m_string) - 1 - insn->text_length, fmt, list);
+    int ret = ((Insn*)stream)->AppendText(style, fmt, list);
     va_end(list);
-
-    insn->type = MISC;
-
-    return insn->LowerCasedSpaceTrimmed(ret, &insn->m_string[insn->text_length] + ret - 1);
+    return ret;
 }
 
 void Insn::Reset() {
+    flags = 0;
+    immediate = 0;
     memory_address = 0;
     text_length = 0;
     instruction_address = 0;
+    operand_count = 0;
+}
+
+/* Restores a previously decoded instruction without running libopcodes. */
+void Insn::Assign(Type type, const char* text, size_t text_length, uint32_t memory_address,
+                  uint32_t instruction_address, size_t size, const Operand* operands, size_t operand_count) {
+    memcpy(m_string, text, text_length);
+    m_string[text_length] = 0;
+    this->text = m_string;
+    this->text_length = text_length;
+    this->type = type;
+    this->memory_address = memory_address;
+    this->instruction_address = instruction_address;
+    this->size = size;
+    memcpy(this->operands, operands, operand_count * sizeof(Operand));
+    this->operand_count = operand_count;
+    SetFlagsFromText();
 }
 
 void Insn::SetSize(size_t size) { this->size = size; }
@@ -155,9 +261,45 @@ void Insn::SetTargetAndType(uint32_t addr, const void* data) {
         }
         memory_address = address;
     } else if (memory_address == 0) {
-        char* addrStr = strstr(text, "s:0x");
-        if (NULL != addrStr) {
-            memory_address = strtol(addrStr + 2, NULL, 16);
+        /* segment override of a memory operand, e.g. %cs:0x1234 */
+        for (size_t i = 0; i < operand_count; ++i) {
+            if (operands[i].offset >= 2 && strncmp(&text[operands[i].offset - 2], "s:", 2) == 0) {
+                memory_address = operands[i].value;
+                break;
+            }
         }
     }
 }
+
+void Insn::SetFlagsFromText() {
+    static const char invalids[][6] = {"(bad)", "ss", "gs"};
+
+    flags = 0;
+    immediate = 0;
+
+    for (size_t i = 0; i < sizeof(invalids) / sizeof(invalids[0]); ++i) {
+        if (strncmp(text, invalids[i], strlen(invalids[i])) == 0) {
+            flags |= INVALID;
+            break;
+        }
+    }
+    if (strncmp(text, "nop", strlen("nop")) == 0) {
+        flags |= NOP;
+    }
+    if (*text == 'f' && strncmp(text, "fs ", strlen("fs ")) != 0) {
+        flags |= FPU;
+        if (strstr(text, "t ") != NULL) {
+            flags |= FPU_M80;
+        } else if (strstr(text, "l ") != NULL) {
+            flags |= FPU_M64;
+        }
+    }
+    if (strchr(text, '*') != NULL) {
+        flags |= INDIRECT;
+    }
+    if (strncmp(text, "mov    $", strlen("mov    $")) == 0) {
+        flags |= MOV_IMMEDIATE;
+        const Operand* source = OperandAt(strlen("mov    $"));
+        immediate = source ? source->value : 0;
+    }
+}
@@ -21,6 +21,7 @@
 
 #include <dis-asm.h>
 
+#include <cstdarg>
 #include <cstdint>
 
 #include "type.hpp"
@@ -30,32 +31,74 @@ class ImageObject;
 class Insn {
 public:
     enum Type { MISC, COND_JUMP, JUMP, CALL, RET };
+    /* Properties of the instruction text the tracing pass relies on. FPU_M80 and FPU_M64 mark the t and l suffixes of
+     * FPU mnemonics, whose memory operands are traced as 10 and 8 bytes of data. INDIRECT marks branches through a
+     * register or memory operand.
+     */
+    enum Flags {
+        INVALID = 0x01,
+        NOP = 0x02,
+        FPU = 0x04,
+        MOV_IMMEDIATE = 0x08,
+        FPU_M80 = 0x10,
+        FPU_M64 = 0x20,
+        INDIRECT = 0x40
+    };
+
+    /* A hexadecimal number of the instruction text, recorded while the text is printed. */
+    class Operand {
+    public:
+        enum Kind { IMMEDIATE, ADDRESS, DISPLACEMENT, TARGET };
+
+        Kind kind;
+        uint32_t value;
+        /* Span of the number including its 0x prefix, relative to text. */
+        uint8_t offset;
+        uint8_t length;
+    };
+    /* The text of an i386 instruction holds at most two numbers, e.g. ljmp $0x10,$0x1234, enter $0x8,$0x0 or
+     * movl $0x1,0x4(%eax). Numbers past MAX_OPERANDS are not recorded and print without their label, the two spare
+     * slots keep that from happening should libopcodes ever print more. */
+    enum { MAX_OPERANDS = 4 };
 
     Type type;
+    unsigned flags;
+    /* Source operand of a MOV_IMMEDIATE instruction. */
+    uint32_t immediate;
     char* text;
     size_t text_length;
     uint32_t memory_address;
     uint32_t instruction_address;
     size_t size;
+    Operand operands[MAX_OPERANDS];
+    size_t operand_count;
 
     explicit Insn(const ImageObject* const image_object_pointer);
 
     ::Bitness GetBitness();
     uint32_t BaseAddress();
+    const ImageObject* ImageObjectPointer() const;
 
     static int CallbackResetTypeAndText(void* stream, const char* fmt, ...);
     static int CallbackResetTypeAndText(void* stream, enum disassembler_style style, const char* fmt, ...);
 
     void Reset();
+    void Assign(Type type, const char* text, size_t text_length, uint32_t memory_address,
+                uint32_t instruction_address, size_t size, const Operand* operands, size_t operand_count);
     void SetSize(size_t size);
     void SetTargetAndType(uint32_t addr, const void* data);
+    void SetFlagsFromText();
+    void MarkLastOperandAsTarget();
 
 private:
     char m_string[128];
     static int m_count;
     const ImageObject* const m_image_object_pointer;
 
-    int LowerCasedSpaceTrimmed(int ret, char* end);
+    int LowerCasedSpaceTrimmed(int ret, char* from, char* end);
+    int AppendText(enum disassembler_style style, const char* fmt, va_list list);
+    void RecordOperands(const char* from, enum disassembler_style style);
+    const Operand* OperandAt(size_t offset) const;
 };
 
 #endif
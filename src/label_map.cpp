@@ -0,0 +1,316 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "label_map.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "image.hpp"
+#include "image_object.hpp"
+
+static bool CompareBaseAddresses(const ImageObject* lhs, const ImageObject* rhs) {
+    return lhs->BaseAddress() < rhs->BaseAddress();
+}
+
+LabelMap::LabelMap(const Image& image) : m_image(&image), m_size(0), m_ids_assigned(false) {
+    std::vector<const ImageObject*> objects;
+    for (size_t n = 0; n < image.objects.size(); ++n) {
+        objects.push_back(&image.objects[n]);
+    }
+    std::sort(objects.begin(), objects.end(), CompareBaseAddresses);
+
+    m_shadows.resize(objects.size());
+    m_object_shadows.resize(objects.size());
+    for (size_t n = 0; n < objects.size(); ++n) {
+        Shadow& shadow = m_shadows[n];
+        shadow.base_address = objects[n]->BaseAddress();
+        shadow.end_address = objects[n]->BaseAddress() + objects[n]->Size();
+        size_t page_count = ((size_t)objects[n]->Size() + PAGE_SIZE - 1) / PAGE_SIZE;
+        shadow.pages.resize(page_count, NO_PAGE);
+        shadow.blocks.resize(page_count, 0);
+        shadow.groups.resize((page_count + 63) / 64, 0);
+        m_object_shadows[objects[n]->Index()] = n;
+    }
+}
+
+const LabelMap::Shadow* LabelMap::ShadowAt(uint32_t address) const {
+    const ImageObject* obj = m_image->FindObject(address);
+    return obj ? &m_shadows[m_object_shadows[obj->Index()]] : NULL;
+}
+
+uint8_t LabelMap::ValueAt(const Shadow& shadow, size_t offset) const {
+    uint32_t page = shadow.pages[offset / PAGE_SIZE];
+    return page == NO_PAGE ? 0 : m_pages[page].bytes[offset % PAGE_SIZE];
+}
+
+bool LabelMap::Get(uint32_t address, Type* type) const {
+    const Shadow* shadow = ShadowAt(address);
+    if (shadow) {
+        uint8_t value = ValueAt(*shadow, address - shadow->base_address);
+        *type = (Type)(value & TYPE_MASK);
+        return value != 0;
+    }
+
+    std::map<uint32_t, Type>::const_iterator itr = m_outside.find(address);
+    if (itr != m_outside.end()) {
+        *type = itr->second;
+        return true;
+    }
+    return false;
+}
+
+bool LabelMap::Contains(uint32_t address) const {
+    Type type;
+    return Get(address, &type);
+}
+
+void LabelMap::Set(uint32_t address, Type type) {
+    Shadow* shadow = const_cast<Shadow*>(ShadowAt(address));
+    if (shadow) {
+        uint32_t offset = address - shadow->base_address;
+        uint32_t& page = shadow->pages[offset / PAGE_SIZE];
+        if (page == NO_PAGE) {
+            page = m_pages.size();
+            m_pages.resize(m_pages.size() + 1);
+        }
+        uint8_t& value = m_pages[page].bytes[offset % PAGE_SIZE];
+        m_ids_assigned = m_ids_assigned && value != 0;
+        m_size += value == 0;
+        value = LABEL | type;
+
+        size_t block = offset / BLOCK_SIZE;
+        shadow->blocks[block / 64] |= 1ULL << (block % 64);
+        shadow->groups[block / 64 / 64] |= 1ULL << (block / 64 % 64);
+    } else {
+        std::pair<std::map<uint32_t, Type>::iterator, bool> result = m_outside.insert(std::make_pair(address, type));
+        result.first->second = type;
+        m_ids_assigned = m_ids_assigned && !result.second;
+        m_size += result.second;
+    }
+}
+
+/* Returns the label type at address, an UNKNOWN label is added if there is none. */
+Type LabelMap::Insert(uint32_t address) {
+    Type type;
+    if (!Get(address, &type)) {
+        type = UNKNOWN;
+        Set(address, type);
+    }
+    return type;
+}
+
+/* Index of the first block at or after block that has a label, or the block count if there is none. */
+size_t LabelMap::FindBlock(const Shadow& shadow, size_t block) {
+    size_t word = block / 64;
+    if (word >= shadow.blocks.size()) {
+        return shadow.blocks.size() * 64;
+    }
+    uint64_t bits = shadow.blocks[word] & (~0ULL << (block % 64));
+    if (bits) {
+        return word * 64 + __builtin_ctzll(bits);
+    }
+
+    size_t group = word + 1;
+    size_t group_word = group / 64;
+    if (group_word >= shadow.groups.size()) {
+        return shadow.blocks.size() * 64;
+    }
+    bits = shadow.groups[group_word] & (~0ULL << (group % 64));
+    while (bits == 0) {
+        if (++group_word == shadow.groups.size()) {
+            return shadow.blocks.size() * 64;
+        }
+        bits = shadow.groups[group_word];
+    }
+    word = group_word * 64 + __builtin_ctzll(bits);
+    return word * 64 + __builtin_ctzll(shadow.blocks[word]);
+}
+
+/* Offset of the first set shadow byte at or after offset, or the shadow size if there is none. */
+size_t LabelMap::FindSet(const Shadow& shadow, size_t offset) const {
+    size_t size = shadow.end_address - shadow.base_address;
+    while (offset < size) {
+        size_t block = FindBlock(shadow, offset / BLOCK_SIZE);
+        if (block * BLOCK_SIZE >= size) {
+            break;
+        }
+        /* A block with a label lies on an allocated page. */
+        const uint8_t* bytes = m_pages[shadow.pages[block / 64]].bytes;
+        size_t page_offset = block / 64 * PAGE_SIZE;
+        offset = std::max(offset, block * BLOCK_SIZE);
+        size_t end = std::min(size, (block + 1) * BLOCK_SIZE);
+        for (; offset < end; ++offset) {
+            if (bytes[offset - page_offset]) {
+                return offset;
+            }
+        }
+    }
+    return size;
+}
+
+/* Finds the first label at or after address. */
+bool LabelMap::LowerBound(uint32_t address, uint32_t* found, Type* type) const {
+    bool have_label = false;
+
+    std::map<uint32_t, Type>::const_iterator itr = m_outside.lower_bound(address);
+    if (itr != m_outside.end()) {
+        *found = itr->first;
+        *type = itr->second;
+        have_label = true;
+    }
+
+    for (size_t n = 0; n < m_shadows.size(); ++n) {
+        const Shadow& shadow = m_shadows[n];
+        if (shadow.end_address <= address || (have_label && shadow.base_address >= *found)) {
+            continue;
+        }
+
+        size_t start = address > shadow.base_address ? address - shadow.base_address : 0;
+        size_t offset = FindSet(shadow, start);
+        if (offset < (size_t)(shadow.end_address - shadow.base_address)) {
+            if (!have_label || shadow.base_address + offset < *found) {
+                *found = shadow.base_address + offset;
+                *type = (Type)(ValueAt(shadow, offset) & TYPE_MASK);
+            }
+            return true;
+        }
+    }
+    return have_label;
+}
+
+/* Finds the first label after address. */
+bool LabelMap::Next(uint32_t address, uint32_t* next, Type* type) const {
+    return address != UINT32_MAX && LowerBound(address + 1, next, type);
+}
+
+size_t LabelMap::Size() const { return m_size; }
+
+void LabelMap::Clear() {
+    for (size_t n = 0; n < m_shadows.size(); ++n) {
+        std::fill(m_shadows[n].pages.begin(), m_shadows[n].pages.end(), (uint32_t)NO_PAGE);
+        std::fill(m_shadows[n].blocks.begin(), m_shadows[n].blocks.end(), 0);
+        std::fill(m_shadows[n].groups.begin(), m_shadows[n].groups.end(), 0);
+    }
+    m_pages.clear();
+    m_outside.clear();
+    m_size = 0;
+    m_ids_assigned = false;
+}
+
+void LabelMap::Swap(LabelMap& other) {
+    std::swap(m_image, other.m_image);
+    m_shadows.swap(other.m_shadows);
+    m_object_shadows.swap(other.m_object_shadows);
+    m_pages.swap(other.m_pages);
+    m_outside.swap(other.m_outside);
+    std::swap(m_size, other.m_size);
+    std::swap(m_ids_assigned, other.m_ids_assigned);
+}
+
+void LabelMap::AssignIds() {
+    uint32_t id = 0;
+    for (size_t n = 0; n < m_shadows.size(); ++n) {
+        const Shadow& shadow = m_shadows[n];
+        for (size_t word = 0; word < shadow.blocks.size(); ++word) {
+            if (shadow.blocks[word] == 0) {
+                continue;
+            }
+            Page& page = m_pages[shadow.pages[word]];
+            for (size_t block = 0; block < PAGE_SIZE / BLOCK_SIZE; ++block) {
+                page.ids[block] = id;
+                if (shadow.blocks[word] & (1ULL << block)) {
+                    for (size_t offset = block * BLOCK_SIZE; offset < (block + 1) * BLOCK_SIZE; ++offset) {
+                        id += page.bytes[offset] != 0;
+                    }
+                }
+            }
+        }
+    }
+    m_ids_assigned = true;
+}
+
+/* Finds the id of the label at address, the ids must have been assigned since the last label was added. */
+bool LabelMap::Id(uint32_t address, size_t* id) const {
+    assert(m_ids_assigned);
+
+    const Shadow* shadow = ShadowAt(address);
+    if (shadow) {
+        size_t offset = address - shadow->base_address;
+        uint32_t page_index = shadow->pages[offset / PAGE_SIZE];
+        if (page_index == NO_PAGE) {
+            return false;
+        }
+        const Page& page = m_pages[page_index];
+        offset %= PAGE_SIZE;
+        if (page.bytes[offset] == 0) {
+            return false;
+        }
+
+        /* Every set byte has the LABEL flag, so the labels before offset in its block are counted 8 at a time. */
+        size_t start = offset / BLOCK_SIZE * BLOCK_SIZE;
+        size_t count = page.ids[offset / BLOCK_SIZE];
+        for (; start + sizeof(uint64_t) <= offset; start += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, page.bytes + start, sizeof(word));
+            count += __builtin_popcountll(word & 0x8080808080808080ULL);
+        }
+        for (; start < offset; ++start) {
+            count += page.bytes[start] != 0;
+        }
+        *id = count;
+        return true;
+    }
+
+    std::map<uint32_t, Type>::const_iterator itr = m_outside.find(address);
+    if (itr == m_outside.end()) {
+        return false;
+    }
+    *id = m_size - m_outside.size() + std::distance(m_outside.begin(), itr);
+    return true;
+}
+
+LabelMap::const_iterator LabelMap::begin() const { return const_iterator(this, false); }
+
+LabelMap::const_iterator LabelMap::end() const { return const_iterator(this, true); }
+
+LabelMap::const_iterator::const_iterator(const LabelMap* map, bool end) : m_map(map), m_value(0, UNKNOWN), m_end(end) {
+    if (!m_end) {
+        m_end = !m_map->LowerBound(0, &m_value.first, &m_value.second);
+    }
+}
+
+const LabelMap::const_iterator::value_type& LabelMap::const_iterator::operator*() const { return m_value; }
+
+const LabelMap::const_iterator::value_type* LabelMap::const_iterator::operator->() const { return &m_value; }
+
+LabelMap::const_iterator& LabelMap::const_iterator::operator++() {
+    m_end = !m_map->Next(m_value.first, &m_value.first, &m_value.second);
+    return *this;
+}
+
+LabelMap::const_iterator LabelMap::const_iterator::operator++(int) {
+    const_iterator previous = *this;
+    ++*this;
+    return previous;
+}
+
+bool LabelMap::const_iterator::operator==(const const_iterator& other) const {
+    return m_end == other.m_end && (m_end || m_value.first == other.m_value.first);
+}
+
+bool LabelMap::const_iterator::operator!=(const const_iterator& other) const { return !(*this == other); }
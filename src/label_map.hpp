@@ -0,0 +1,121 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LE_DISASM_LABEL_MAP_HPP_
+#define LE_DISASM_LABEL_MAP_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "type.hpp"
+
+class Image;
+
+/* Label types by address. Every image object has a shadow with one byte per address, a set byte holds the LABEL flag
+ * and the label type, so lookups take constant time. The shadow bytes are allocated a page of 4 KiB at a time when the
+ * first label is set on the page, so large uninitialized objects cost next to nothing. Two bitmaps summarize which 64
+ * byte blocks and which groups of 64 blocks hold labels, so finding the next label skips empty spans a word at a time.
+ * The few labels outside of all objects, like the end address of the last object, are kept in a std::map.
+ * AssignIds() numbers the labels densely, the labels of the objects in address order before those outside of them.
+ */
+class LabelMap {
+public:
+    class const_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::pair<uint32_t, Type> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const value_type* pointer;
+        typedef const value_type& reference;
+
+        const_iterator(const LabelMap* map, bool end);
+
+        const value_type& operator*() const;
+        const value_type* operator->() const;
+        const_iterator& operator++();
+        const_iterator operator++(int);
+        bool operator==(const const_iterator& other) const;
+        bool operator!=(const const_iterator& other) const;
+
+    private:
+        const LabelMap* m_map;
+        value_type m_value;
+        bool m_end;
+    };
+
+    explicit LabelMap(const Image& image);
+
+    bool Get(uint32_t address, Type* type) const;
+    bool Contains(uint32_t address) const;
+    void Set(uint32_t address, Type type);
+    Type Insert(uint32_t address);
+    bool LowerBound(uint32_t address, uint32_t* found, Type* type) const;
+    bool Next(uint32_t address, uint32_t* next, Type* type) const;
+    size_t Size() const;
+    void Clear();
+    void Swap(LabelMap& other);
+    void AssignIds();
+    bool Id(uint32_t address, size_t* id) const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+private:
+    enum { LABEL = 0x80, TYPE_MASK = 0x7f, BLOCK_SIZE = 64, PAGE_SIZE = BLOCK_SIZE * 64 };
+    enum { NO_PAGE = 0xffffffff };
+
+    class Page {
+    public:
+        uint8_t bytes[PAGE_SIZE];
+        /* Id of the first label at or after each block, filled in by AssignIds(). */
+        uint32_t ids[PAGE_SIZE / BLOCK_SIZE];
+    };
+
+    class Shadow {
+    public:
+        uint32_t base_address;
+        uint32_t end_address;
+        /* Index into m_pages of each page of the object, or NO_PAGE while the page has no label. */
+        std::vector<uint32_t> pages;
+        /* Bit n of word w is set if block w * 64 + n has a label, word w covers page w. */
+        std::vector<uint64_t> blocks;
+        /* Bit n of word w is set if blocks[w * 64 + n] is non-zero. */
+        std::vector<uint64_t> groups;
+    };
+
+    const Image* m_image;
+    /* Sorted by base address. */
+    std::vector<Shadow> m_shadows;
+    /* Index into m_shadows of each image object. */
+    std::vector<size_t> m_object_shadows;
+    std::deque<Page> m_pages;
+    std::map<uint32_t, Type> m_outside;
+    size_t m_size;
+    /* Ids are only valid until labels are added or removed. */
+    bool m_ids_assigned;
+
+    const Shadow* ShadowAt(uint32_t address) const;
+    uint8_t ValueAt(const Shadow& shadow, size_t offset) const;
+    size_t FindSet(const Shadow& shadow, size_t offset) const;
+    static size_t FindBlock(const Shadow& shadow, size_t block);
+};
+
+#endif
@@ -18,8 +18,12 @@
 
 #include "linear_executable.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <string>
+#include <thread>
 
+#include "error.hpp"
 #include "fixup.hpp"
 #include "little_endian.hpp"
 
@@ -36,55 +40,189 @@ size_t LinearExecutable::OffsetOfPageInFile(size_t index) const {
 }
 
 template <typename T>
-void LinearExecutable::LoadTable(std::istream& is, uint32_t count, std::vector<T>& ret) {
+void LinearExecutable::LoadTable(ByteCursor& cursor, uint32_t count, std::vector<T>& ret) {
     ret.resize(count);
     for (uint32_t n = 0; n < count; ++n) {
-        ret[n].ReadFrom(is);
+        ret[n].ReadFrom(cursor);
     }
 }
 
-void LinearExecutable::LoadObjectFixups(std::istream& is, std::vector<uint32_t>& fixup_record_offsets,
-                                        size_t table_offset, size_t oi) {
-    ObjectHeader& obj = objects[oi];
-    if (verbose) std::cerr << "Loading fixups for object " << oi + 1 << std::endl;
-    for (size_t n = obj.first_page_index; n < obj.first_page_index + obj.page_count; ++n) {
-        size_t offset = table_offset + fixup_record_offsets[n];
-        size_t end = table_offset + fixup_record_offsets[n + 1];
-        size_t page_offset = (n - obj.first_page_index) * header.page_size;
-        for (is.seekg(offset); offset < end;) {
-            if (verbose)
-                std::cerr << "Loading fixup 0x" << offset << " at page " << std::dec << (n + 1 - obj.first_page_index)
-                          << "/" << obj.page_count << ", offset 0x" << std::hex << page_offset << ": ";
-            Fixup fixup(is, offset, objects, page_offset);
-            fixups[oi][fixup.offset] = fixup.address;
-            fixup_addresses.insert(fixup.address);
-            if (verbose) std::cerr << "0x" << fixup.offset << " -> 0x" << fixup.address << std::endl;
+void LinearExecutable::CountFixups(ByteCursor& cursor, std::vector<uint32_t>& fixup_record_offsets,
+                                   size_t table_offset, std::vector<FixupPage>& pages, bool& uses_entry_table) {
+    size_t index = 0;
+    fixup_record_ranges.resize(objects.size() + 1);
+    for (size_t oi = 0; oi < objects.size(); ++oi) {
+        ObjectHeader& obj = objects[oi];
+        size_t page_end = std::min<size_t>(obj.first_page_index + obj.page_count, header.page_count);
+        fixup_record_ranges[oi] = index;
+        for (size_t n = obj.first_page_index; n < page_end; ++n) {
+            FixupPage page;
+            page.object = oi;
+            page.page = n;
+            page.first_record = index;
+            cursor.Seek(table_offset + fixup_record_offsets[n]);
+            index += FixupDecoder::Count(cursor, table_offset + fixup_record_offsets[n + 1], uses_entry_table);
+            page.last_record = index;
+            pages.push_back(page);
+        }
+    }
+    fixup_record_ranges[objects.size()] = index;
+}
+
+void LinearExecutable::DecodeFixupPages(ByteCursor cursor, const FixupDecoder& decoder,
+                                        const std::vector<uint32_t>& fixup_record_offsets, size_t table_offset,
+                                        const FixupPage* first, const FixupPage* last) {
+    for (const FixupPage* page = first; page != last; ++page) {
+        ObjectHeader& obj = objects[page->object];
+        size_t end = table_offset + fixup_record_offsets[page->page + 1];
+        size_t page_offset = (page->page - obj.first_page_index) * header.page_size;
+        size_t index = page->first_record;
+        if (verbose && page->page == obj.first_page_index) {
+            std::cerr << "Loading fixups for object " << page->object + 1 << std::endl;
+        }
+        for (cursor.Seek(table_offset + fixup_record_offsets[page->page]); cursor.Offset() < end;) {
+            size_t record_offset = cursor.Offset();
+            size_t count = decoder.Decode(cursor, page->object, page_offset, &fixup_records[index]);
+            for (size_t n = index; verbose && n < index + count; ++n) {
+                const Fixup& fixup = fixup_records[n];
+                std::cerr << "Loading fixup 0x" << record_offset << " at page " << std::dec
+                          << (page->page + 1 - obj.first_page_index) << "/" << obj.page_count << ", offset 0x"
+                          << std::hex << page_offset << ": ";
+                if (fixup.IsResolved()) {
+                    std::cerr << "0x" << fixup.offset << " -> 0x" << fixup.address << std::endl;
+                } else {
+                    std::cerr << "0x" << fixup.offset << " -> import" << std::endl;
+                }
+            }
+            index += count;
+        }
+        if (index != page->last_record) {
+            throw Error() << "Fixup record count mismatch on page " << std::dec << page->page + 1;
         }
     }
 }
 
-void LinearExecutable::LoadFixupTable(std::istream& is, std::vector<uint32_t>& fixup_record_offsets,
-                                      size_t table_offset) {
+void LinearExecutable::DecodeFixupPagesParallel(ByteCursor& cursor, const FixupDecoder& decoder,
+                                                const std::vector<uint32_t>& fixup_record_offsets,
+                                                size_t table_offset, const std::vector<FixupPage>& pages,
+                                                unsigned jobs) {
+    std::vector<std::thread> workers;
+    std::vector<std::string> errors(jobs);
+    size_t total = fixup_records.size();
+    size_t first = 0;
+
+    /* Split the pages into contiguous runs of roughly equal record count, every page owns its slots in
+     * fixup_records so the workers never touch the same memory. */
+    for (unsigned job = 0; job < jobs && first < pages.size(); ++job) {
+        size_t target = total * (job + 1) / jobs;
+        size_t last = first + 1;
+        while (last < pages.size() && (job + 1 == jobs || pages[last - 1].last_record < target)) {
+            ++last;
+        }
+        const FixupPage* begin = &pages[first];
+        const FixupPage* end = begin + (last - first);
+        std::string* error = &errors[job];
+        workers.push_back(std::thread([this, cursor, &decoder, &fixup_record_offsets, table_offset, begin, end,
+                                       error]() {
+            try {
+                DecodeFixupPages(cursor, decoder, fixup_record_offsets, table_offset, begin, end);
+            } catch (const std::exception& e) {
+                *error = e.what();
+            }
+        }));
+        first = last;
+    }
+
+    for (size_t n = 0; n < workers.size(); ++n) {
+        workers[n].join();
+    }
+
+    for (size_t n = 0; n < errors.size(); ++n) {
+        if (!errors[n].empty()) {
+            throw Error() << errors[n];
+        }
+    }
+}
+
+static bool CompareFixupOffsets(const Fixup* lhs, const Fixup* rhs) { return lhs->offset < rhs->offset; }
+
+void LinearExecutable::IndexFixups() {
+    std::vector<uint32_t> addresses;
+    std::vector<const Fixup*> sorted;
+
     fixups.resize(objects.size());
     for (size_t oi = 0; oi < objects.size(); ++oi) {
-        LoadObjectFixups(is, fixup_record_offsets, table_offset, oi);
+        sorted.clear();
+        for (size_t n = fixup_record_ranges[oi]; n < fixup_record_ranges[oi + 1]; ++n) {
+            const Fixup& fixup = fixup_records[n];
+            if (fixup.IsResolved()) {
+                addresses.push_back(fixup.address);
+                if (!fixup.IsRelative()) {
+                    sorted.push_back(&fixup);
+                }
+            }
+        }
+
+        /* Several records may patch the same offset, the one decoded last wins as it is applied last. */
+        std::stable_sort(sorted.begin(), sorted.end(), CompareFixupOffsets);
+        std::vector<uint32_t> object_offsets;
+        std::vector<uint32_t> object_addresses;
+        object_offsets.reserve(sorted.size());
+        object_addresses.reserve(sorted.size());
+        for (size_t n = 0; n < sorted.size(); ++n) {
+            if (n + 1 < sorted.size() && sorted[n + 1]->offset == sorted[n]->offset) {
+                continue;
+            }
+            object_offsets.push_back(sorted[n]->offset);
+            object_addresses.push_back(sorted[n]->address);
+        }
+        fixups[oi].Assign(object_offsets, object_addresses);
+    }
+
+    std::sort(addresses.begin(), addresses.end());
+    addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+    addresses.shrink_to_fit();
+    fixup_addresses.Assign(addresses);
+}
+
+void LinearExecutable::LoadFixupTable(ByteCursor& cursor, std::vector<uint32_t>& fixup_record_offsets,
+                                      size_t table_offset, uint32_t header_offset, unsigned jobs) {
+    std::vector<FixupPage> pages;
+    bool uses_entry_table = false;
+
+    CountFixups(cursor, fixup_record_offsets, table_offset, pages, uses_entry_table);
+    if (uses_entry_table) {
+        cursor.Seek(header_offset + header.entry_table_offset);
+        entry_table.ReadFrom(cursor);
+    }
+
+    FixupDecoder decoder(objects, entry_table);
+    fixup_records.resize(fixup_record_ranges.back());
+    if (jobs > 1 && !verbose && pages.size() > 1) {
+        DecodeFixupPagesParallel(cursor, decoder, fixup_record_offsets, table_offset, pages, jobs);
+    } else if (!pages.empty()) {
+        DecodeFixupPages(cursor, decoder, fixup_record_offsets, table_offset, &pages.front(),
+                         &pages.front() + pages.size());
     }
+    IndexFixups();
 }
 
-LinearExecutable::LinearExecutable(std::istream& is, bool verbose, uint32_t header_offset) : header(is, header_offset) {
+LinearExecutable::LinearExecutable(ByteCursor cursor, bool verbose, uint32_t header_offset, unsigned jobs)
+    : header(cursor, header_offset) {
     this->verbose = verbose;
-    is.seekg(header_offset + header.object_table_offset);
-    LoadTable(is, header.object_count, objects);
+    cursor.Seek(header_offset + header.object_table_offset);
+    LoadTable(cursor, header.object_count, objects);
 
-    is.seekg(header_offset + header.object_page_table_offset);
-    LoadTable(is, header.page_count, object_pages);
+    cursor.Seek(header_offset + header.object_page_table_offset);
+    LoadTable(cursor, header.page_count, object_pages);
 
     std::vector<uint32_t> fixup_record_offsets;
-    is.seekg(header_offset + header.fixup_page_table_offset);
+    cursor.Seek(header_offset + header.fixup_page_table_offset).Require(sizeof(uint32_t) * (header.page_count + 1));
     fixup_record_offsets.resize(header.page_count + 1);
     for (size_t n = 0; n <= header.page_count; ++n) {
-        ReadLe(is, fixup_record_offsets[n]);
+        cursor.ReadUnchecked(fixup_record_offsets[n]);
     }
 
-    LoadFixupTable(is, fixup_record_offsets, header_offset + header.fixup_record_table_offset);
+    LoadFixupTable(cursor, fixup_record_offsets, header_offset + header.fixup_record_table_offset, header_offset,
+                   jobs);
 }
@@ -19,36 +19,59 @@
 #ifndef LE_DISASM_LINEAR_EXECUTABLE_HPP_
 #define LE_DISASM_LINEAR_EXECUTABLE_HPP_
 
+#include <cstddef>
 #include <cstdint>
-#include <istream>
-#include <map>
-#include <set>
 #include <vector>
 
+#include "entry_table.hpp"
+#include "fixup.hpp"
+#include "fixup_index.hpp"
 #include "header.hpp"
 #include "object_header.hpp"
 #include "object_page_header.hpp"
 
+class ByteCursor;
+
 class LinearExecutable {
 public:
     Header header;
     std::vector<ObjectHeader> objects;
     std::vector<ObjectPageHeader> object_pages;
-    std::vector<std::map<uint32_t, uint32_t> > fixups;
-    std::set<uint32_t> fixup_addresses;
+    EntryTable entry_table;
+    /* Decoded fixup records of all objects in page order, object n owns [fixup_record_ranges[n], [n + 1]). */
+    std::vector<Fixup> fixup_records;
+    std::vector<size_t> fixup_record_ranges;
+    /* Resolved absolute fixups of each object and the set of all resolved fixup targets. */
+    std::vector<FixupIndex> fixups;
+    SortedKeys fixup_addresses;
     bool verbose;
 
-    LinearExecutable(std::istream& is, bool verbose, uint32_t header_offset = 0);
+    LinearExecutable(ByteCursor cursor, bool verbose, uint32_t header_offset = 0, unsigned jobs = 1);
 
     uint32_t EntryPointAddress();
     size_t OffsetOfPageInFile(size_t index) const;
 
 private:
+    struct FixupPage {
+        size_t object;
+        size_t page;
+        size_t first_record;
+        size_t last_record;
+    };
+
     template <typename T>
-    void LoadTable(std::istream& is, uint32_t count, std::vector<T>& ret);
-    void LoadObjectFixups(std::istream& is, std::vector<uint32_t>& fixup_record_offsets, size_t table_offset,
-                          size_t oi);
-    void LoadFixupTable(std::istream& is, std::vector<uint32_t>& fixup_record_offsets, size_t table_offset);
+    void LoadTable(ByteCursor& cursor, uint32_t count, std::vector<T>& ret);
+    void CountFixups(ByteCursor& cursor, std::vector<uint32_t>& fixup_record_offsets, size_t table_offset,
+                     std::vector<FixupPage>& pages, bool& uses_entry_table);
+    void DecodeFixupPages(ByteCursor cursor, const FixupDecoder& decoder,
+                          const std::vector<uint32_t>& fixup_record_offsets, size_t table_offset,
+                          const FixupPage* first, const FixupPage* last);
+    void DecodeFixupPagesParallel(ByteCursor& cursor, const FixupDecoder& decoder,
+                                  const std::vector<uint32_t>& fixup_record_offsets, size_t table_offset,
+                                  const std::vector<FixupPage>& pages, unsigned jobs);
+    void IndexFixups();
+    void LoadFixupTable(ByteCursor& cursor, std::vector<uint32_t>& fixup_record_offsets, size_t table_offset,
+                        uint32_t header_offset, unsigned jobs);
 };
 
 #endif
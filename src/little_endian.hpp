@@ -19,7 +19,8 @@
 #ifndef LE_DISASM_LITTLE_ENDIAN_HPP_
 #define LE_DISASM_LITTLE_ENDIAN_HPP_
 
-#include <istream>
+#include <cstddef>
+#include <cstdint>
 
 #include "error.hpp"
 
@@ -32,15 +33,6 @@ static void ReadLe(const void* memory, T& value) {
     }
 }
 
-template <typename T>
-void ReadLe(std::istream& is, T& ret) {
-    char buffer[sizeof(T)];
-    for (is.read(buffer, sizeof(T)); !is.good();) {
-        throw Error() << "EOF";
-    }
-    ReadLe<T, sizeof(T)>(buffer, ret);
-}
-
 template <typename T>
 T ReadLe(const void* memory) {
     T ret;
@@ -62,4 +54,70 @@ void WriteLe(const void* memory, T value) {
     WriteLe<T, sizeof(T)>(memory, value);
 }
 
+/* Sequential little endian reader over a contiguous buffer. Records are bounds checked once with Require() and
+ * their fields are then read with ReadUnchecked(), Read() checks every field on its own.
+ */
+class ByteCursor {
+public:
+    ByteCursor(const void* data, size_t size, size_t offset = 0)
+        : m_begin((const uint8_t*)data), m_end((const uint8_t*)data + size), m_pos(m_begin) {
+        Seek(offset);
+    }
+
+    size_t Offset() const { return m_pos - m_begin; }
+    size_t Size() const { return m_end - m_begin; }
+    size_t Remaining() const { return m_end - m_pos; }
+    const uint8_t* Position() const { return m_pos; }
+
+    ByteCursor& Seek(size_t offset) {
+        if (offset > Size()) {
+            throw Error() << "EOF";
+        }
+        m_pos = m_begin + offset;
+        return *this;
+    }
+
+    ByteCursor& Require(size_t bytes) {
+        if (bytes > Remaining()) {
+            throw Error() << "EOF";
+        }
+        return *this;
+    }
+
+    ByteCursor& Skip(size_t bytes) {
+        Require(bytes);
+        m_pos += bytes;
+        return *this;
+    }
+
+    template <typename T>
+    T ReadUnchecked() {
+        T value;
+        ReadLe<T, sizeof(T)>(m_pos, value);
+        m_pos += sizeof(T);
+        return value;
+    }
+
+    template <typename T>
+    void ReadUnchecked(T& value) {
+        value = ReadUnchecked<T>();
+    }
+
+    template <typename T>
+    T Read() {
+        Require(sizeof(T));
+        return ReadUnchecked<T>();
+    }
+
+    template <typename T>
+    void Read(T& value) {
+        value = Read<T>();
+    }
+
+private:
+    const uint8_t* m_begin;
+    const uint8_t* m_end;
+    const uint8_t* m_pos;
+};
+
 #endif
@@ -18,21 +18,39 @@
 
 #include <cstring>
 #include <fstream>
+#include <vector>
 
 #ifndef PACKAGE
 #define PACKAGE
 #endif
 
-#include "analyzer.hpp"
-#include "emitter.hpp"
-#include "image.hpp"
-#include "linear_executable.hpp"
+#include "batch.hpp"
+#include "error.hpp"
 #include "options.hpp"
-#include "symbol_map.hpp"
+#include "session.hpp"
+
+static void Disassemble(Options& options, const std::string& executable_file, const std::string& map_file,
+                        const std::string& dump_file, unsigned jobs, std::ostream& os) {
+    Session session(executable_file, map_file, options.IsVerbose(), jobs);
+
+    if (dump_file.compare("") != 0) {
+        if (session.DumpImage(dump_file, options.IsTrimPadding())) {
+            std::cerr << "Dumped flat linear executable image to " << dump_file << std::endl;
+        }
+    }
+
+    session.SetVerifyDecoder(options.IsVerifyDecoder());
+    session.SetScanPrologues(options.IsScanPrologues());
+    session.Analyze(options.GetCacheDir(), options.IsIncremental());
+    session.Emit(os);
+}
+
+static void DisassembleBatchJob(Options& options, const BatchJob& job, std::ostream& os) {
+    Disassemble(options, job.executable_file, job.map_file, "", 1, os);
+}
 
 int main(int argc, char** argv) {
     Options options = Options(argc, argv);
-    SymbolMap* map_ptr = 0;
 
     if (options.IsVersion()) {
         std::cout << "le_disasm version" << __DATE__ << std::endl;
@@ -46,6 +64,13 @@ int main(int argc, char** argv) {
                   << "  -d <file>, --dump-image=<file>\tDump flat linear executable image to <file>\n"
                   << "  -t, --trim-padding\t\tTrim zero padding bytes from the start of dumped image (use with -d)\n"
                   << "  -m <map-file>, --map-file=<map-file>\tUse <map-file> to help <executable-file> analysis\n"
+                  << "  -o <file>, --output=<file>\tWrite the disassembly to <file> instead of standard output\n"
+                  << "  -j <n>, --jobs=<n>\t\tThreads for fixups, code decoding or batch jobs (0 uses all cores)\n"
+                  << "  --cache-dir=<dir>\t\tReuse analysis results cached in <dir>\n"
+                  << "  --incremental\t\t\tOnly analyze map file entries added since the last run (needs --cache-dir)\n"
+                  << "  --verify-decoder\t\tCheck the native instruction decoder against libopcodes while tracing\n"
+                  << "  --scan-prologues\t\tFind functions only reachable indirectly by their prologue\n"
+                  << "  --batch=<manifest>\t\tDisassemble each '<exe> <output> [<map-file>]' line of <manifest>\n"
                   << "  -h, --help\t\t\tPrint this help message\n"
                   << "  -V, --version\t\t\tPrint version information\n"
                   << std::endl;
@@ -53,33 +78,26 @@ int main(int argc, char** argv) {
     }
 
     try {
-        std::ifstream is(options.GetExecutableFile(), std::ios::binary);
-        if (!is.is_open()) {
-            std::cerr << "Error opening executable-file: " << options.GetExecutableFile() << std::endl;
-            return -1;
+        if (options.GetBatchFile().compare("") != 0) {
+            Batch batch(options.GetBatchFile());
+            using namespace std::placeholders;
+            return batch.Run(options.GetJobs(), std::bind(DisassembleBatchJob, std::ref(options), _1, _2)) ? 1 : 0;
         }
 
-        LinearExecutable lx(is, options.IsVerbose());
-        Image image(is, lx);
-
-        if (options.GetBinaryImageFile().compare("") != 0) {
-            if (image.OutputFlatMemoryDump(options.GetBinaryImageFile(), options.IsTrimPadding())) {
-                std::cerr << "Dumped flat linear executable image to " << options.GetBinaryImageFile() << std::endl;
+        const std::string& output_file = options.GetOutputFile();
+        if (output_file.compare("") != 0) {
+            std::ofstream os(output_file.c_str(), std::ofstream::binary | std::ofstream::trunc);
+            if (!os.is_open()) {
+                throw Error() << "Error opening output file: " << output_file;
             }
-        }
-
-        if (options.GetMapFile().compare("") != 0) {
-            map_ptr = new SymbolMap(options.GetMapFile().c_str());
-        }
-
-        Analyzer analyzer(lx, image, options.IsVerbose());
-        analyzer.Run(lx, map_ptr);
-
-        Emitter emitter(lx, image, analyzer, map_ptr);
-        emitter.Run();
-
-        if (map_ptr) {
-            delete map_ptr;
+            Disassemble(options, options.GetExecutableFile(), options.GetMapFile(), options.GetBinaryImageFile(),
+                        options.GetJobs(), os);
+            if (!os.flush()) {
+                throw Error() << "Error writing output file: " << output_file;
+            }
+        } else {
+            Disassemble(options, options.GetExecutableFile(), options.GetMapFile(), options.GetBinaryImageFile(),
+                        options.GetJobs(), std::cout);
         }
     } catch (const std::exception& e) {
         std::cerr << std::dec << e.what() << std::endl;
@@ -0,0 +1,128 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mapped_file.hpp"
+
+#include <fstream>
+
+#include "error.hpp"
+
+#if defined(WINDOWS_BUILD)
+#include <windows.h>
+#elif defined(UNIX_BUILD)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path) : m_data(NULL), m_size(0), m_mapped(false) {
+#ifdef WINDOWS_BUILD
+    m_file_handle = INVALID_HANDLE_VALUE;
+    m_mapping_handle = NULL;
+#endif
+    if (!Map(path)) {
+        ReadIntoBuffer(path);
+    }
+}
+
+MappedFile::~MappedFile() {
+#if defined(WINDOWS_BUILD)
+    if (m_mapped) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping_handle) {
+        CloseHandle(m_mapping_handle);
+    }
+    if (m_file_handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_file_handle);
+    }
+#elif defined(UNIX_BUILD)
+    if (m_mapped) {
+        munmap((void*)m_data, m_size);
+    }
+#endif
+}
+
+bool MappedFile::Map(const std::string& path) {
+#if defined(WINDOWS_BUILD)
+    m_file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (m_file_handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file_handle, &size) || size.QuadPart == 0) {
+        return false;
+    }
+    m_mapping_handle = CreateFileMappingA(m_file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!m_mapping_handle) {
+        return false;
+    }
+    void* view = MapViewOfFile(m_mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        return false;
+    }
+    m_data = (const uint8_t*)view;
+    m_size = (size_t)size.QuadPart;
+    m_mapped = true;
+    return true;
+#elif defined(UNIX_BUILD)
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    m_data = (const uint8_t*)view;
+    m_size = (size_t)st.st_size;
+    m_mapped = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void MappedFile::ReadIntoBuffer(const std::string& path) {
+    std::ifstream is(path.c_str(), std::ios::binary);
+    if (!is.is_open()) {
+        throw Error() << "Error opening executable-file: " << path;
+    }
+    m_buffer.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    m_data = m_buffer.empty() ? NULL : &m_buffer.front();
+    m_size = m_buffer.size();
+}
+
+const uint8_t* MappedFile::Data() const { return m_data; }
+
+size_t MappedFile::Size() const { return m_size; }
+
+bool MappedFile::IsMapped() const { return m_mapped; }
+
+const uint8_t* MappedFile::GetSpan(size_t offset, size_t size) const {
+    if (offset > m_size || size > m_size - offset) {
+        throw Error() << "EOF";
+    }
+    return m_data + offset;
+}
@@ -0,0 +1,51 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LE_DISASM_MAPPED_FILE_HPP_
+#define LE_DISASM_MAPPED_FILE_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    const uint8_t* Data() const;
+    size_t Size() const;
+    bool IsMapped() const;
+    const uint8_t* GetSpan(size_t offset, size_t size) const;
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    bool m_mapped;
+    std::vector<uint8_t> m_buffer;
+#ifdef WINDOWS_BUILD
+    void* m_file_handle;
+    void* m_mapping_handle;
+#endif
+
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    bool Map(const std::string& path);
+    void ReadIntoBuffer(const std::string& path);
+};
+
+#endif
@@ -20,13 +20,14 @@
 
 #include "little_endian.hpp"
 
-void ObjectHeader::ReadFrom(std::istream& is) {
-    ReadLe(is, virtual_size);
-    ReadLe(is, base_address);
-    ReadLe(is, flags);
-    ReadLe(is, first_page_index);
-    ReadLe(is, page_count);
-    ReadLe(is, reserved);
+void ObjectHeader::ReadFrom(ByteCursor& cursor) {
+    cursor.Require(RECORD_SIZE);
+    cursor.ReadUnchecked(virtual_size);
+    cursor.ReadUnchecked(base_address);
+    cursor.ReadUnchecked(flags);
+    cursor.ReadUnchecked(first_page_index);
+    cursor.ReadUnchecked(page_count);
+    cursor.ReadUnchecked(reserved);
     --first_page_index;
 }
 
@@ -20,7 +20,8 @@
 #define LE_DISASM_OBJECT_HEADER_HPP_
 
 #include <cstdint>
-#include <istream>
+
+class ByteCursor;
 
 class ObjectHeader {
 public:
@@ -45,7 +46,9 @@ public:
     uint32_t page_count;
     uint32_t reserved;
 
-    void ReadFrom(std::istream& is);
+    enum { RECORD_SIZE = 6 * sizeof(uint32_t) };
+
+    void ReadFrom(ByteCursor& cursor);
     bool IsExecutable() const;
     bool Is32BitObject() const;
 };
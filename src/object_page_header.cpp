@@ -21,11 +21,12 @@
 #include "error.hpp"
 #include "little_endian.hpp"
 
-void ObjectPageHeader::ReadFrom(std::istream& is) {
-    ReadLe(is, first_number);
-    ReadLe(is, second_number);
+void ObjectPageHeader::ReadFrom(ByteCursor& cursor) {
+    cursor.Require(RECORD_SIZE);
+    cursor.ReadUnchecked(first_number);
+    cursor.ReadUnchecked(second_number);
     uint8_t byte;
-    for (ReadLe(is, byte); byte > 4;) {
+    for (cursor.ReadUnchecked(byte); byte > 4;) {
         throw Error() << "Invalid object page type: " << byte;
     }
     type = (ObjectPageType)byte;
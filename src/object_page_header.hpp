@@ -20,7 +20,8 @@
 #define LE_DISASM_OBJECT_PAGE_HEADER_HPP_
 
 #include <cstdint>
-#include <istream>
+
+class ByteCursor;
 
 class ObjectPageHeader {
 public:
@@ -30,7 +31,9 @@ public:
     uint8_t second_number;
     ObjectPageType type;
 
-    void ReadFrom(std::istream& is);
+    enum { RECORD_SIZE = sizeof(uint16_t) + 2 * sizeof(uint8_t) };
+
+    void ReadFrom(ByteCursor& cursor);
 };
 
 #endif
@@ -18,14 +18,32 @@
 
 #include <getopt.h>
 
+#include <cstdlib>
+#include <thread>
+
+static unsigned ParseJobs(const char* value) {
+    unsigned long jobs = value ? std::strtoul(value, 0, 10) : 1;
+    if (jobs == 0) {
+        jobs = std::thread::hardware_concurrency();
+    }
+    return jobs ? jobs : 1;
+}
+
 Options::Options(int argc, char** argv) {
     m_verbose = 0;
     m_version = 0;
     m_help = 0;
     m_trim_padding = 0;
+    m_incremental = 0;
+    m_verify_decoder = 0;
+    m_scan_prologues = 0;
+    m_jobs = 1;
     m_binary_image_file = "";
     m_map_file = "";
+    m_output_file = "";
     m_executable_file = "";
+    m_cache_dir = "";
+    m_batch_file = "";
 
     struct option long_options[] = {{"verbose", no_argument, &m_verbose, 1},
                                     {"brief", no_argument, &m_verbose, 0},
@@ -34,6 +52,13 @@ Options::Options(int argc, char** argv) {
                                     {"dump-image", required_argument, 0, 'd'},
                                     {"map-file", required_argument, 0, 'm'},
                                     {"trim-padding", no_argument, 0, 't'},
+                                    {"jobs", required_argument, 0, 'j'},
+                                    {"cache-dir", required_argument, 0, 0},
+                                    {"incremental", no_argument, &m_incremental, 1},
+                                    {"batch", required_argument, 0, 0},
+                                    {"verify-decoder", no_argument, &m_verify_decoder, 1},
+                                    {"scan-prologues", no_argument, &m_scan_prologues, 1},
+                                    {"output", required_argument, 0, 'o'},
                                     {0, 0, 0, 0}};
 
     {
@@ -42,7 +67,7 @@ Options::Options(int argc, char** argv) {
         for (;;) {
             int option_index = 0;
 
-            c = getopt_long(argc, argv, "vbhVd:m:t", long_options, &option_index);
+            c = getopt_long(argc, argv, "vbhVd:m:o:tj:", long_options, &option_index);
             if (c == -1) break;
 
             switch (c) {
@@ -55,6 +80,15 @@ Options::Options(int argc, char** argv) {
                         case MAP_FILE:
                             m_map_file = optarg ? std::string(optarg) : "";
                             break;
+                        case JOBS:
+                            m_jobs = ParseJobs(optarg);
+                            break;
+                        case CACHE_DIR:
+                            m_cache_dir = optarg ? std::string(optarg) : "";
+                            break;
+                        case BATCH_FILE:
+                            m_batch_file = optarg ? std::string(optarg) : "";
+                            break;
                     }
                     break;
 
@@ -82,10 +116,18 @@ Options::Options(int argc, char** argv) {
                     m_map_file = optarg ? std::string(optarg) : "";
                     break;
 
+                case 'o':
+                    m_output_file = optarg ? std::string(optarg) : "";
+                    break;
+
                 case 't':
                     m_trim_padding = 1;
                     break;
 
+                case 'j':
+                    m_jobs = ParseJobs(optarg);
+                    break;
+
                 case '?':
                     break;
 
@@ -108,8 +150,22 @@ bool Options::IsVersion() { return m_version ? true : false; }
 
 bool Options::IsTrimPadding() { return m_trim_padding ? true : false; }
 
+bool Options::IsIncremental() { return m_incremental ? true : false; }
+
+bool Options::IsVerifyDecoder() { return m_verify_decoder ? true : false; }
+
+bool Options::IsScanPrologues() { return m_scan_prologues ? true : false; }
+
+unsigned Options::GetJobs() { return m_jobs; }
+
+std::string& Options::GetCacheDir() { return m_cache_dir; }
+
+std::string& Options::GetBatchFile() { return m_batch_file; }
+
 std::string& Options::GetMapFile() { return m_map_file; }
 
+std::string& Options::GetOutputFile() { return m_output_file; }
+
 std::string& Options::GetBinaryImageFile() { return m_binary_image_file; }
 
 std::string& Options::GetExecutableFile() { return m_executable_file; }
@@ -27,20 +27,34 @@ public:
     bool IsHelp();
     bool IsVersion();
     bool IsTrimPadding();
+    bool IsIncremental();
+    bool IsVerifyDecoder();
+    bool IsScanPrologues();
+    unsigned GetJobs();
+    std::string& GetCacheDir();
+    std::string& GetBatchFile();
     std::string& GetMapFile();
+    std::string& GetOutputFile();
     std::string& GetBinaryImageFile();
     std::string& GetExecutableFile();
 
 private:
-    enum { DUMP_IMAGE = 4, MAP_FILE = 5 };
+    enum { DUMP_IMAGE = 4, MAP_FILE = 5, JOBS = 7, CACHE_DIR = 8, BATCH_FILE = 10 };
 
     int m_verbose;
     int m_version;
     int m_help;
     int m_trim_padding;
+    int m_incremental;
+    int m_verify_decoder;
+    int m_scan_prologues;
+    unsigned m_jobs;
     std::string m_binary_image_file;
     std::string m_map_file;
+    std::string m_output_file;
     std::string m_executable_file;
+    std::string m_cache_dir;
+    std::string m_batch_file;
 };
 
 #endif
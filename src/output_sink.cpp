@@ -0,0 +1,64 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "output_sink.hpp"
+
+#include <cstring>
+
+OutputSink::OutputSink(std::streambuf* target, size_t size) : m_target(target), m_buffer(size ? size : 1) {
+    setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+}
+
+OutputSink::~OutputSink() { Drain(); }
+
+/* Passes the buffered bytes on to the target, the buffer is emptied even if the target fails. */
+bool OutputSink::Drain() {
+    std::streamsize size = pptr() - pbase();
+    bool result = size == 0 || m_target->sputn(pbase(), size) == size;
+    setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+    return result;
+}
+
+OutputSink::int_type OutputSink::overflow(int_type c) {
+    if (!Drain()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+/* Blocks that do not fit into the buffer are written straight to the target instead of being split up. */
+std::streamsize OutputSink::xsputn(const char* s, std::streamsize n) {
+    if (n <= epptr() - pptr()) {
+        memcpy(pptr(), s, n);
+        pbump(n);
+        return n;
+    }
+    if (!Drain()) {
+        return 0;
+    }
+    if (n < epptr() - pptr()) {
+        memcpy(pptr(), s, n);
+        pbump(n);
+        return n;
+    }
+    return m_target->sputn(s, n);
+}
+
+int OutputSink::sync() { return Drain() && m_target->pubsync() == 0 ? 0 : -1; }
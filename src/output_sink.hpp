@@ -0,0 +1,50 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LE_DISASM_OUTPUT_SINK_HPP_
+#define LE_DISASM_OUTPUT_SINK_HPP_
+
+#include <cstddef>
+#include <streambuf>
+#include <vector>
+
+/* Stream buffer that collects output in a large user-space buffer and passes it on to the target stream buffer in
+ * big blocks. Nothing reaches the target before the buffer is full or the sink is explicitly flushed, so the many
+ * small writes of the emitter do not each end up in a system call.
+ */
+class OutputSink : public std::streambuf {
+public:
+    enum { BUFFER_SIZE = 1 << 20 };
+
+    explicit OutputSink(std::streambuf* target, size_t size = BUFFER_SIZE);
+    ~OutputSink();
+
+protected:
+    int_type overflow(int_type c);
+    std::streamsize xsputn(const char* s, std::streamsize n);
+    int sync();
+
+private:
+    std::streambuf* m_target;
+    std::vector<char> m_buffer;
+
+    OutputSink(const OutputSink&);
+    OutputSink& operator=(const OutputSink&);
+
+    bool Drain();
+};
+
+#endif
@@ -0,0 +1,220 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pre_decoder.hpp"
+
+#include <algorithm>
+#include <exception>
+
+#include "image.hpp"
+#include "image_object.hpp"
+#include "insn.hpp"
+#include "x86_decoder.hpp"
+
+PreDecoder::Worker::Worker() : record_count(0) {}
+
+PreDecoder::PreDecoder(const Image& image)
+    : m_image(image), m_index(image.objects.size()), m_pending(0), m_stop(false) {}
+
+PreDecoder::~PreDecoder() { Stop(); }
+
+/* Starts decoding everything reachable from seeds on workers threads. Seeds outside of executable objects are
+ * ignored.
+ */
+void PreDecoder::Start(const std::vector<uint32_t>& seeds, unsigned workers) {
+    Stop();
+    workers = std::max(1u, std::min<unsigned>(workers, MAX_WORKERS));
+
+    for (size_t n = 0; n < m_image.objects.size(); ++n) {
+        const ImageObject& obj = m_image.objects[n];
+        if (obj.IsExecutable()) {
+            m_index[n].reset(new std::atomic<uint32_t>[obj.Size()]);
+            for (uint32_t offset = 0; offset < obj.Size(); ++offset) {
+                m_index[n][offset].store(FREE, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    for (unsigned n = 0; n < workers; ++n) {
+        m_workers.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+    for (size_t n = 0; n < seeds.size(); ++n) {
+        Push(n % workers, seeds[n]);
+    }
+
+    m_stop = false;
+    for (unsigned n = 0; n < workers; ++n) {
+        m_threads.push_back(std::thread(&PreDecoder::Work, this, n));
+    }
+}
+
+/* Stops the workers and releases the decoded instructions. Returns the number of instructions decoded ahead. */
+size_t PreDecoder::Stop() {
+    size_t count = 0;
+
+    m_stop = true;
+    for (size_t n = 0; n < m_threads.size(); ++n) {
+        m_threads[n].join();
+    }
+    for (size_t n = 0; n < m_workers.size(); ++n) {
+        count += m_workers[n]->record_count;
+    }
+
+    m_threads.clear();
+    m_workers.clear();
+    for (size_t n = 0; n < m_index.size(); ++n) {
+        m_index[n].reset();
+    }
+    m_pending = 0;
+    return count;
+}
+
+/* Restores the instruction at address if a worker decoded it already. An instruction is only handed out if it fits
+ * into length, one that was cut short by the end of a shorter buffer could decode differently.
+ */
+bool PreDecoder::Lookup(uint32_t address, size_t length, Insn& insn) const {
+    const ImageObject* obj = insn.ImageObjectPointer();
+    const std::unique_ptr<std::atomic<uint32_t>[]>& index = m_index[obj->Index()];
+    if (!index) {
+        return false;
+    }
+
+    uint32_t slot = index[address - obj->BaseAddress()].load(std::memory_order_acquire);
+    if (slot == FREE || slot == CLAIMED) {
+        return false;
+    }
+
+    uint32_t record_index = (slot & ((1u << RECORD_BITS) - 1)) - 1;
+    const Record& record = m_workers[slot >> RECORD_BITS]->chunks[record_index >> CHUNK_BITS]
+                                                                [record_index & ((1u << CHUNK_BITS) - 1)];
+    if (record.size > length) {
+        return false;
+    }
+
+    insn.Assign(static_cast<Insn::Type>(record.type), "", 0, record.memory_address, address, record.size, NULL, 0);
+    insn.flags = record.flags;
+    insn.immediate = record.immediate;
+    return true;
+}
+
+const ImageObject* PreDecoder::ExecutableObjectAt(uint32_t address) const {
+    const ImageObject* obj = m_image.FindObject(address);
+    return obj && obj->IsExecutable() ? obj : NULL;
+}
+
+void PreDecoder::Push(size_t worker, uint32_t address) {
+    ++m_pending;
+    std::lock_guard<std::mutex> lock(m_workers[worker]->mutex);
+    m_workers[worker]->addresses.push_back(address);
+}
+
+/* The owner works depth first from the back of its deque, thieves take the oldest run starts from the front. */
+bool PreDecoder::Pop(size_t worker, uint32_t& address) {
+    std::lock_guard<std::mutex> lock(m_workers[worker]->mutex);
+    if (m_workers[worker]->addresses.empty()) {
+        return false;
+    }
+    address = m_workers[worker]->addresses.back();
+    m_workers[worker]->addresses.pop_back();
+    return true;
+}
+
+bool PreDecoder::Steal(size_t worker, uint32_t& address) {
+    std::lock_guard<std::mutex> lock(m_workers[worker]->mutex);
+    if (m_workers[worker]->addresses.empty()) {
+        return false;
+    }
+    address = m_workers[worker]->addresses.front();
+    m_workers[worker]->addresses.pop_front();
+    return true;
+}
+
+/* Returns false once every deque is empty and no worker is left that could push new run starts. */
+bool PreDecoder::Next(size_t worker, uint32_t& address) {
+    for (;;) {
+        if (Pop(worker, address)) {
+            return true;
+        }
+        for (size_t n = 1; n < m_workers.size(); ++n) {
+            if (Steal((worker + n) % m_workers.size(), address)) {
+                return true;
+            }
+        }
+        if (m_pending.load() == 0 || m_stop) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+}
+
+void PreDecoder::Work(size_t worker) {
+    uint32_t address;
+    while (!m_stop && Next(worker, address)) {
+        try {
+            DecodeRun(worker, address);
+        } catch (const std::exception&) {
+            /* the tracer decodes the instruction again and reports the error */
+        }
+        --m_pending;
+    }
+}
+
+/* Decodes instructions from address until a jump, a return or a byte that was claimed by another run. Instructions
+ * the native decoder rejects end the run as well, the tracer falls back to libopcodes for them.
+ */
+void PreDecoder::DecodeRun(size_t worker, uint32_t address) {
+    const ImageObject* obj = ExecutableObjectAt(address);
+    if (obj == NULL) {
+        return;
+    }
+
+    std::atomic<uint32_t>* index = m_index[obj->Index()].get();
+    Worker& self = *m_workers[worker];
+    uint32_t end_address = obj->BaseAddress() + obj->Size();
+    Insn inst(obj);
+
+    for (uint32_t addr = address; addr < end_address && self.record_count < MAX_RECORDS; addr += inst.size) {
+        std::atomic<uint32_t>& slot = index[addr - obj->BaseAddress()];
+        uint32_t expected = FREE;
+        if (!slot.compare_exchange_strong(expected, CLAIMED)) {
+            return;
+        }
+        if (!X86Decoder::Decode(addr, obj->GetDataAt(addr), end_address - addr, inst) || inst.size == 0) {
+            return;
+        }
+
+        std::unique_ptr<Record[]>& chunk = self.chunks[self.record_count >> CHUNK_BITS];
+        if (!chunk) {
+            chunk.reset(new Record[1 << CHUNK_BITS]);
+        }
+        Record& record = chunk[self.record_count & ((1u << CHUNK_BITS) - 1)];
+        record.memory_address = inst.memory_address;
+        record.immediate = inst.immediate;
+        record.size = inst.size;
+        record.type = inst.type;
+        record.flags = inst.flags;
+        ++self.record_count;
+        slot.store((worker << RECORD_BITS) | self.record_count, std::memory_order_release);
+
+        if ((Insn::COND_JUMP == inst.type || Insn::JUMP == inst.type || Insn::CALL == inst.type) &&
+            inst.memory_address != 0) {
+            Push(worker, inst.memory_address);
+        }
+        if (Insn::JUMP == inst.type || Insn::RET == inst.type) {
+            return;
+        }
+    }
+}
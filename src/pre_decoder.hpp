@@ -0,0 +1,88 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LE_DISASM_PRE_DECODER_HPP_
+#define LE_DISASM_PRE_DECODER_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Image;
+class ImageObject;
+class Insn;
+
+/* Decodes the code reachable from a set of seed addresses on a pool of threads while the analyzer traces. Every
+ * worker follows linear runs of instructions and the direct branch targets found in them, it owns a deque of run start
+ * addresses and steals from the other workers when its own deque runs dry. The tracer itself stays serial and only
+ * picks up instructions that were already decoded, so the analysis result does not depend on how far the workers got.
+ */
+class PreDecoder {
+public:
+    explicit PreDecoder(const Image& image);
+    ~PreDecoder();
+
+    void Start(const std::vector<uint32_t>& seeds, unsigned workers);
+    size_t Stop();
+    bool Lookup(uint32_t address, size_t length, Insn& insn) const;
+
+private:
+    /* Slots of the per byte index hold the worker in the top bits and its record index plus one below. */
+    enum { MAX_WORKERS = 32, RECORD_BITS = 27, CHUNK_BITS = 16, MAX_RECORDS = (1 << RECORD_BITS) - 2 };
+    static const uint32_t FREE = 0;
+    static const uint32_t CLAIMED = 0xffffffff;
+
+    class Record {
+    public:
+        uint32_t memory_address;
+        uint32_t immediate;
+        uint8_t size;
+        uint8_t type;
+        uint8_t flags;
+    };
+
+    /* Records are stored in fixed chunks that never move, the tracer reads them while the worker appends. */
+    class Worker {
+    public:
+        std::mutex mutex;
+        std::deque<uint32_t> addresses;
+        std::unique_ptr<Record[]> chunks[1 << (RECORD_BITS - CHUNK_BITS)];
+        size_t record_count;
+
+        Worker();
+    };
+
+    const Image& m_image;
+    std::vector<std::unique_ptr<std::atomic<uint32_t>[]> > m_index;
+    std::vector<std::unique_ptr<Worker> > m_workers;
+    std::vector<std::thread> m_threads;
+    std::atomic<size_t> m_pending;
+    std::atomic<bool> m_stop;
+
+    const ImageObject* ExecutableObjectAt(uint32_t address) const;
+    void Push(size_t worker, uint32_t address);
+    bool Pop(size_t worker, uint32_t& address);
+    bool Steal(size_t worker, uint32_t& address);
+    bool Next(size_t worker, uint32_t& address);
+    void Work(size_t worker);
+    void DecodeRun(size_t worker, uint32_t address);
+};
+
+#endif
@@ -23,6 +23,25 @@ std::ostream& PrintAddress(std::ostream& os, uint32_t address, const char* prefi
     return os << prefix << std::setfill('0') << std::setw(6) << std::hex << std::noshowbase << address;
 }
 
+/* Ending of generated label names, which follows the address of the label. */
+const char* LabelSuffix(Type type) {
+    switch (type) {
+        case FUNCTION:
+        case FUNC_GUESS:
+            return "_func";
+        case JUMP:
+            return "_jump";
+        case DATA:
+            return "_data";
+        case SWITCH:
+            return "_switch";
+        case CASE:
+            return "_case";
+        default:
+            return "_unknown";
+    }
+}
+
 std::ostream& operator<<(std::ostream& os, Type type) {
     switch (type) {
         case UNKNOWN:
@@ -28,6 +28,7 @@
 #include "type.hpp"
 
 std::ostream& PrintAddress(std::ostream& os, uint32_t address, const char* prefix);
+const char* LabelSuffix(Type type);
 std::ostream& operator<<(std::ostream& os, Type type);
 std::ostream& operator<<(std::ostream& os, const Region& reg);
 
@@ -0,0 +1,166 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "region_map.hpp"
+
+#include <algorithm>
+
+RegionMap::RegionMap() : m_size(0) {}
+
+RegionMap::iterator RegionMap::begin() { return iterator(this, 0, 0); }
+
+RegionMap::iterator RegionMap::end() { return iterator(this, m_blocks.size(), 0); }
+
+RegionMap::const_iterator RegionMap::begin() const { return const_iterator(this, 0, 0); }
+
+RegionMap::const_iterator RegionMap::end() const { return const_iterator(this, m_blocks.size(), 0); }
+
+size_t RegionMap::size() const { return m_size; }
+
+bool RegionMap::empty() const { return m_size == 0; }
+
+/* Index of the block that holds address or would have to hold it. */
+size_t RegionMap::BlockOf(uint32_t address) const {
+    std::vector<uint32_t>::const_iterator itr =
+        std::upper_bound(m_first_addresses.begin(), m_first_addresses.end(), address);
+    return itr == m_first_addresses.begin() ? 0 : itr - m_first_addresses.begin() - 1;
+}
+
+bool RegionMap::IsBelow(const Entry& entry, uint32_t address) { return entry.address < address; }
+
+bool RegionMap::IsAbove(uint32_t address, const Entry& entry) { return address < entry.address; }
+
+/* Position of the first entry of a block at or above address. */
+size_t RegionMap::LowerIndex(const std::vector<Entry>& entries, uint32_t address) {
+    return std::lower_bound(entries.begin(), entries.end(), address, IsBelow) - entries.begin();
+}
+
+/* Moves positions past the end of a block to the start of the next one. */
+RegionMap::iterator RegionMap::MakeIterator(size_t block, size_t index) {
+    if (block < m_blocks.size() && index == m_blocks[block].size()) {
+        ++block;
+        index = 0;
+    }
+    return iterator(this, block, index);
+}
+
+RegionMap::iterator RegionMap::lower_bound(uint32_t address) {
+    if (m_blocks.empty()) {
+        return end();
+    }
+    size_t block = BlockOf(address);
+    return MakeIterator(block, LowerIndex(m_blocks[block], address));
+}
+
+RegionMap::iterator RegionMap::upper_bound(uint32_t address) {
+    if (m_blocks.empty()) {
+        return end();
+    }
+    size_t block = BlockOf(address);
+    const std::vector<Entry>& entries = m_blocks[block];
+    return MakeIterator(block, std::upper_bound(entries.begin(), entries.end(), address, IsAbove) - entries.begin());
+}
+
+RegionMap::iterator RegionMap::find(uint32_t address) {
+    iterator itr = lower_bound(address);
+    return (itr != end() && itr->first == address) ? itr : end();
+}
+
+RegionMap::Node* RegionMap::NewNode(uint32_t address) {
+    Node* node;
+    if (m_free_nodes.empty()) {
+        m_nodes.push_back(Node());
+        node = &m_nodes.back();
+    } else {
+        node = m_free_nodes.back();
+        m_free_nodes.pop_back();
+    }
+    node->first = address;
+    node->second = Region();
+    return node;
+}
+
+/* Returns the region at address, a default constructed region is inserted if there is none. */
+Region& RegionMap::operator[](uint32_t address) {
+    if (m_blocks.empty()) {
+        m_blocks.push_back(std::vector<Entry>());
+        m_first_addresses.push_back(address);
+    }
+
+    size_t block = BlockOf(address);
+    std::vector<Entry>& entries = m_blocks[block];
+    size_t index = LowerIndex(entries, address);
+    if (index < entries.size() && entries[index].address == address) {
+        return entries[index].node->second;
+    }
+
+    Entry entry;
+    entry.address = address;
+    entry.node = NewNode(address);
+    entries.insert(entries.begin() + index, entry);
+    m_first_addresses[block] = entries.front().address;
+    ++m_size;
+
+    if (entries.size() > MAX_BLOCK_SIZE) {
+        std::vector<Entry> upper(entries.begin() + MAX_BLOCK_SIZE / 2, entries.end());
+        entries.resize(MAX_BLOCK_SIZE / 2);
+        m_first_addresses.insert(m_first_addresses.begin() + block + 1, upper.front().address);
+        m_blocks.insert(m_blocks.begin() + block + 1, std::vector<Entry>());
+        m_blocks[block + 1].swap(upper);
+    }
+    return entry.node->second;
+}
+
+size_t RegionMap::erase(uint32_t address) {
+    if (m_blocks.empty()) {
+        return 0;
+    }
+
+    size_t block = BlockOf(address);
+    std::vector<Entry>& entries = m_blocks[block];
+    size_t index = LowerIndex(entries, address);
+    if (index == entries.size() || entries[index].address != address) {
+        return 0;
+    }
+
+    m_free_nodes.push_back(entries[index].node);
+    entries.erase(entries.begin() + index);
+    --m_size;
+
+    if (entries.empty()) {
+        m_blocks.erase(m_blocks.begin() + block);
+        m_first_addresses.erase(m_first_addresses.begin() + block);
+    } else {
+        m_first_addresses[block] = entries.front().address;
+    }
+    return 1;
+}
+
+void RegionMap::swap(RegionMap& other) {
+    m_blocks.swap(other.m_blocks);
+    m_first_addresses.swap(other.m_first_addresses);
+    m_nodes.swap(other.m_nodes);
+    m_free_nodes.swap(other.m_free_nodes);
+    std::swap(m_size, other.m_size);
+}
+
+void RegionMap::clear() {
+    m_blocks.clear();
+    m_first_addresses.clear();
+    m_nodes.clear();
+    m_free_nodes.clear();
+    m_size = 0;
+}
@@ -0,0 +1,143 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LE_DISASM_REGION_MAP_HPP_
+#define LE_DISASM_REGION_MAP_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <vector>
+
+#include "region.hpp"
+
+/* Ordered address to region map. Keys are kept in small sorted blocks with a sorted directory of the first key of
+ * every block, a lookup is two binary searches over contiguous arrays and an insert only moves the entries of one
+ * block. Regions live in a pool and keep their address until they are erased, like the nodes of a std::map, so Region
+ * pointers stay valid while other regions are split or merged. Iterators are invalidated by inserts and erases.
+ */
+class RegionMap {
+public:
+    class Node {
+    public:
+        uint32_t first;
+        Region second;
+    };
+
+    typedef Node value_type;
+
+    template <typename T>
+    class Iterator {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T* pointer;
+        typedef T& reference;
+
+        Iterator() : m_map(NULL), m_block(0), m_index(0) {}
+        Iterator(const RegionMap* map, size_t block, size_t index) : m_map(map), m_block(block), m_index(index) {}
+        template <typename U>
+        Iterator(const Iterator<U>& other) : m_map(other.m_map), m_block(other.m_block), m_index(other.m_index) {}
+
+        T& operator*() const { return *m_map->m_blocks[m_block][m_index].node; }
+        T* operator->() const { return m_map->m_blocks[m_block][m_index].node; }
+
+        Iterator& operator++() {
+            if (++m_index == m_map->m_blocks[m_block].size()) {
+                ++m_block;
+                m_index = 0;
+            }
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+        Iterator& operator--() {
+            if (m_index == 0) {
+                m_index = m_map->m_blocks[--m_block].size();
+            }
+            --m_index;
+            return *this;
+        }
+        Iterator operator--(int) {
+            Iterator next = *this;
+            --*this;
+            return next;
+        }
+
+        bool operator==(const Iterator& other) const { return m_block == other.m_block && m_index == other.m_index; }
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+    private:
+        template <typename U>
+        friend class Iterator;
+
+        const RegionMap* m_map;
+        size_t m_block;
+        size_t m_index;
+    };
+
+    typedef Iterator<Node> iterator;
+    typedef Iterator<const Node> const_iterator;
+
+    RegionMap();
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+    size_t size() const;
+    bool empty() const;
+
+    iterator find(uint32_t address);
+    iterator lower_bound(uint32_t address);
+    iterator upper_bound(uint32_t address);
+    Region& operator[](uint32_t address);
+    size_t erase(uint32_t address);
+    void swap(RegionMap& other);
+    void clear();
+
+private:
+    enum { MAX_BLOCK_SIZE = 64 };
+
+    class Entry {
+    public:
+        uint32_t address;
+        Node* node;
+    };
+
+    std::vector<std::vector<Entry> > m_blocks;
+    std::vector<uint32_t> m_first_addresses;
+    std::deque<Node> m_nodes;
+    std::vector<Node*> m_free_nodes;
+    size_t m_size;
+
+    static bool IsBelow(const Entry& entry, uint32_t address);
+    static bool IsAbove(uint32_t address, const Entry& entry);
+    static size_t LowerIndex(const std::vector<Entry>& entries, uint32_t address);
+    size_t BlockOf(uint32_t address) const;
+    iterator MakeIterator(size_t block, size_t index);
+    Node* NewNode(uint32_t address);
+
+    RegionMap(const RegionMap&);
+    RegionMap& operator=(const RegionMap&);
+};
+
+#endif
@@ -21,11 +21,13 @@
 #include <cassert>
 #include <iostream>
 
+#include "image.hpp"
 #include "image_object.hpp"
 #include "print.hpp"
 
-Regions::Regions(std::vector<ImageObject>& objects, bool verbose) {
+Regions::Regions(Image& image, bool verbose) : label_types(image) {
     this->verbose = verbose;
+    std::vector<ImageObject>& objects = image.objects;
     for (size_t n = 0; n < objects.size(); ++n) {
         ImageObject& obj = objects[n];
         Type type = obj.IsExecutable() ? UNKNOWN : DATA;
@@ -33,22 +35,17 @@ Regions::Regions(std::vector<ImageObject>& objects, bool verbose) {
             << ", " << std::dec << obj.Size() << ", " << type << ")" << std::endl;
         regions[obj.BaseAddress()] = Region(obj.BaseAddress(), obj.Size(), type, std::addressof(obj));
         if (type == DATA) {
-            label_types[obj.BaseAddress()] = type;
+            label_types.Set(obj.BaseAddress(), type);
         }
     }
 }
 
 uint32_t Regions::GetLabelType(uint32_t address, Type* label) {
-    const std::map<uint32_t, Type>::iterator item = label_types.find(address);
-    if (label_types.end() != item) {
-        *label = item->second;
-        return item->first;
-    }
-    return 0;
+    return label_types.Get(address, label) ? address : 0;
 }
 
 Region* Regions::RegionContaining(uint32_t address) {
-    std::map<uint32_t, Region>::iterator itr = regions.lower_bound(address);
+    RegionMap::iterator itr = regions.lower_bound(address);
     if (regions.end() != itr) {
         if (itr->first == address) {
             return &itr->second;
@@ -95,12 +92,12 @@ void Regions::SplitInsert(Region& parent, const Region& target) {
 }
 
 Region* Regions::NextRegion(const Region& reg) {
-    std::map<uint32_t, Region>::iterator itr = regions.upper_bound(reg.Address());
+    RegionMap::iterator itr = regions.upper_bound(reg.Address());
     return regions.end() != itr ? &itr->second : NULL;
 }
 
 Region* Regions::PreviousRegion(const Region& reg) {
-    for (std::map<uint32_t, Region>::iterator itr = regions.lower_bound(reg.Address()); regions.begin() != itr;) {
+    for (RegionMap::iterator itr = regions.lower_bound(reg.Address()); regions.begin() != itr;) {
         --itr;
         return &itr->second;
     }
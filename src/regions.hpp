@@ -20,20 +20,21 @@
 #define LE_DISASM_REGIONS_HPP_
 
 #include <cstdint>
-#include <map>
 #include <vector>
 
+#include "label_map.hpp"
 #include "region.hpp"
+#include "region_map.hpp"
 
-class ImageObject;
+class Image;
 
 class Regions {
 public:
-    std::map<uint32_t, Region> regions;
-    std::map<uint32_t, Type> label_types;
+    RegionMap regions;
+    LabelMap label_types;
     bool verbose;
 
-    Regions(std::vector<ImageObject>& objects, bool verbose);
+    Regions(Image& image, bool verbose);
 
     uint32_t GetLabelType(uint32_t address, Type* label);
     Region* RegionContaining(uint32_t address);
@@ -0,0 +1,146 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "session.hpp"
+
+#include <cstring>
+#include <vector>
+
+#include "analysis_cache.hpp"
+#include "dis_info.hpp"
+#include "emitter.hpp"
+#include "error.hpp"
+#include "little_endian.hpp"
+
+Session::Session(const std::string& executable_file, const std::string& map_file, bool verbose, unsigned jobs)
+    : m_file(executable_file),
+      m_map_file(map_file),
+      m_lx(ByteCursor(m_file.Data(), m_file.Size()), verbose, 0, jobs),
+      m_image(m_file, m_lx),
+      m_map(map_file.empty() ? NULL : new SymbolMap(map_file.c_str())),
+      m_analyzer(m_lx, m_image, verbose) {
+    m_analyzer.jobs = jobs;
+}
+
+/* Traces with libopcodes and reports where the native instruction decoder disagrees with it. */
+void Session::SetVerifyDecoder(bool enable) { m_analyzer.verify_decoder = enable; }
+
+/* Looks for functions that are only reachable indirectly by their prologue. */
+void Session::SetScanPrologues(bool enable) { m_analyzer.scan_prologues = enable; }
+
+/* Runs the analysis once and freezes its result, an empty cache_dir disables the on-disk analysis cache. The labels of
+ * the analyzer and the relocation targets of the executable move into the snapshot. */
+void Session::Analyze(const std::string& cache_dir, bool incremental) {
+    if (m_snapshot) {
+        return;
+    }
+
+    if (!cache_dir.empty()) {
+        AnalysisCache cache(cache_dir, m_file, m_map_file, m_analyzer.scan_prologues);
+        if (!cache.Load(m_analyzer, m_lx)) {
+            std::vector<uint32_t> added;
+            if (incremental && cache.LoadPrevious(m_analyzer, m_lx, m_map.get(), added)) {
+                m_analyzer.RunIncremental(m_lx, m_map.get(), added);
+            } else {
+                m_analyzer.Run(m_lx, m_map.get());
+            }
+            cache.Save(m_analyzer, m_map.get());
+        }
+    } else {
+        m_analyzer.Run(m_lx, m_map.get());
+    }
+
+    m_snapshot.reset(new Snapshot(m_image, m_analyzer.regions, m_lx.fixup_addresses, m_map.get()));
+}
+
+void Session::Emit(std::ostream& os) {
+    Analyze();
+
+    Emitter emitter(m_lx, m_image, *m_snapshot, m_map.get(), m_analyzer.jobs, os);
+    emitter.Run();
+}
+
+bool Session::DumpImage(const std::string& path, bool trim_padding) {
+    std::string file_path = path;
+    return m_image.OutputFlatMemoryDump(file_path, trim_padding);
+}
+
+/* The snapshot and the queries reading it are only available after Analyze(). */
+const Snapshot& Session::GetSnapshot() const {
+    if (!m_snapshot) {
+        throw Error() << "Executable is not analyzed yet";
+    }
+    return *m_snapshot;
+}
+
+const std::vector<Region>& Session::GetRegions() const { return GetSnapshot().GetRegions(); }
+
+const LabelMap& Session::GetLabels() const { return GetSnapshot().GetLabels(); }
+
+/* The decoders store the destination of direct jumps and calls in memory_address, while indirect ones like
+ * jmp *0x1234(,%eax,4) keep their memory operand there.
+ */
+static bool IsDirectBranch(const Insn& inst) {
+    return (inst.type == Insn::JUMP || inst.type == Insn::COND_JUMP || inst.type == Insn::CALL) &&
+           std::memchr(inst.text, '*', inst.text_length) == NULL;
+}
+
+/* Decodes the instructions of a code region in address order. Returns the number of visited instructions. */
+size_t Session::ForEachInstruction(const Region& reg, const InstructionVisitor& visitor) const {
+    if (reg.GetType() != CODE) {
+        throw Error() << "Region at 0x" << std::hex << reg.Address() << " does not contain code";
+    }
+
+    const ImageObject& obj = *reg.ImageObjectPointer();
+    Insn inst(std::addressof(obj));
+    DisInfo disasm;
+    Instruction instruction;
+    size_t count = 0;
+
+    for (uint32_t addr = reg.Address(); addr < reg.EndAddress(); addr += inst.size) {
+        disasm.Disassemble(addr, obj.GetDataAt(addr), reg.EndAddress() - addr, inst);
+        if (inst.size == 0) {
+            break;
+        }
+
+        instruction.address = addr;
+        instruction.size = inst.size;
+        instruction.type = inst.type;
+        if (IsDirectBranch(inst)) {
+            instruction.memory_address = 0;
+            instruction.target_address = inst.memory_address;
+        } else {
+            instruction.memory_address = inst.memory_address;
+            instruction.target_address = 0;
+        }
+        instruction.text.assign(inst.text, inst.text_length);
+        ++count;
+
+        if (!visitor(instruction)) {
+            break;
+        }
+    }
+
+    return count;
+}
+
+LinearExecutable& Session::GetExecutable() { return m_lx; }
+
+Image& Session::GetImage() { return m_image; }
+
+Analyzer& Session::GetAnalyzer() { return m_analyzer; }
+
+SymbolMap* Session::GetSymbolMap() { return m_map.get(); }
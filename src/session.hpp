@@ -0,0 +1,90 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LE_DISASM_SESSION_HPP_
+#define LE_DISASM_SESSION_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "analyzer.hpp"
+#include "image.hpp"
+#include "insn.hpp"
+#include "linear_executable.hpp"
+#include "mapped_file.hpp"
+#include "snapshot.hpp"
+#include "symbol_map.hpp"
+
+/* Embeddable entry point of the le_disasm_core library. A session owns everything needed to disassemble one linear
+ * executable: it loads the image, runs the analysis and gives access to the resulting regions, labels and decoded
+ * instructions without going through the textual assembly output. Everything after the analysis reads its frozen
+ * snapshot, so the const queries may be called from several threads and Emit() may be called repeatedly.
+ */
+class Session {
+public:
+    class Instruction {
+    public:
+        uint32_t address;
+        uint32_t size;
+        Insn::Type type;
+        /* Absolute address referenced by a memory operand or zero. */
+        uint32_t memory_address;
+        /* Target of a direct jump or call instruction or zero. */
+        uint32_t target_address;
+        /* Lower cased libopcodes (AT&T syntax) text without label substitution. */
+        std::string text;
+    };
+
+    /* Returning false stops the iteration. */
+    typedef std::function<bool(const Instruction&)> InstructionVisitor;
+
+    Session(const std::string& executable_file, const std::string& map_file = "", bool verbose = false,
+            unsigned jobs = 1);
+
+    void SetVerifyDecoder(bool enable);
+    void SetScanPrologues(bool enable);
+    void Analyze(const std::string& cache_dir = "", bool incremental = false);
+    void Emit(std::ostream& os);
+    bool DumpImage(const std::string& path, bool trim_padding = false);
+
+    const Snapshot& GetSnapshot() const;
+    const std::vector<Region>& GetRegions() const;
+    const LabelMap& GetLabels() const;
+    size_t ForEachInstruction(const Region& reg, const InstructionVisitor& visitor) const;
+
+    LinearExecutable& GetExecutable();
+    Image& GetImage();
+    Analyzer& GetAnalyzer();
+    SymbolMap* GetSymbolMap();
+
+private:
+    MappedFile m_file;
+    std::string m_map_file;
+    LinearExecutable m_lx;
+    Image m_image;
+    std::unique_ptr<SymbolMap> m_map;
+    Analyzer m_analyzer;
+    std::unique_ptr<Snapshot> m_snapshot;
+
+    Session(const Session&);
+    Session& operator=(const Session&);
+};
+
+#endif
@@ -0,0 +1,194 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "snapshot.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "image.hpp"
+#include "little_endian.hpp"
+#include "print.hpp"
+#include "regions.hpp"
+#include "symbol_map.hpp"
+
+static bool AddressBefore(uint32_t address, const Region& reg) { return address < reg.Address(); }
+
+/* Appends the name PrintAddress() and LabelSuffix() would print for a label without a symbol map entry. */
+static void AppendGeneratedName(std::string& names, uint32_t address, Type type) {
+    static const char digits[] = "0123456789abcdef";
+    char buffer[8];
+    size_t start = sizeof(buffer);
+    do {
+        buffer[--start] = digits[address & 0xf];
+        address >>= 4;
+    } while (address != 0 || start > 2);
+
+    names += '_';
+    names.append(buffer + start, sizeof(buffer) - start);
+    names += LabelSuffix(type);
+}
+
+static bool LateLabelLess(const std::pair<uint32_t, uint64_t>& label, uint32_t address) {
+    return label.first < address;
+}
+
+/* The labels and the relocation targets are swapped out of regions and fixup_addresses, which are left empty. */
+Snapshot::Snapshot(const Image& image, Regions& regions, SortedKeys& fixup_addresses, SymbolMap* map)
+    : m_labels(image) {
+    m_labels.Swap(regions.label_types);
+    m_fixup_addresses.Swap(fixup_addresses);
+    m_regions.reserve(regions.regions.size());
+    for (RegionMap::const_iterator itr = regions.regions.begin(); itr != regions.regions.end(); ++itr) {
+        m_regions.push_back(itr->second);
+    }
+
+    AddSwitchLabels(image);
+    AddLabelNames(map);
+}
+
+const std::vector<Region>& Snapshot::GetRegions() const { return m_regions; }
+
+const LabelMap& Snapshot::GetLabels() const { return m_labels; }
+
+const Region* Snapshot::RegionContaining(uint32_t address) const {
+    std::vector<Region>::const_iterator itr =
+        std::upper_bound(m_regions.begin(), m_regions.end(), address, AddressBefore);
+    if (itr == m_regions.begin()) {
+        return NULL;
+    }
+    --itr;
+    return itr->ContainsAddress(address) ? &*itr : NULL;
+}
+
+const Region* Snapshot::NextRegion(const Region& reg) const {
+    std::vector<Region>::const_iterator itr =
+        std::upper_bound(m_regions.begin(), m_regions.end(), reg.Address(), AddressBefore);
+    return m_regions.end() != itr ? &*itr : NULL;
+}
+
+bool Snapshot::IsFixupAddress(uint32_t address) const { return m_fixup_addresses.Contains(address); }
+
+/* Orders the moments of the sequential output: printing address itself comes before anything printed after it. */
+uint64_t Snapshot::OutputPosition(uint32_t address, bool after) { return (uint64_t)address * 2 + (after ? 1 : 0); }
+
+/* Returns whether there is a label at address that is already printed at the given output position. */
+bool Snapshot::LabelAt(uint32_t address, uint64_t position, Type* type) const {
+    if (!m_labels.Get(address, type)) {
+        return false;
+    }
+    if (m_late_labels.empty()) {
+        return true;
+    }
+    std::vector<std::pair<uint32_t, uint64_t> >::const_iterator itr =
+        std::lower_bound(m_late_labels.begin(), m_late_labels.end(), address, LateLabelLess);
+    return itr == m_late_labels.end() || itr->first != address || itr->second <= position;
+}
+
+bool Snapshot::NextLabel(uint32_t address, uint64_t position, uint32_t* next) const {
+    Type type;
+    while (m_labels.Next(address, next, &type)) {
+        if (LabelAt(*next, position, &type)) {
+            return true;
+        }
+        address = *next;
+    }
+    return false;
+}
+
+/* Returns the name to print for the label at address as a reference of the given type, or NULL if there is no
+ * label or its generated name has a different suffix.
+ */
+const char* Snapshot::LabelName(uint32_t address, Type type, size_t* length) const {
+    size_t id;
+    if (!m_labels.Id(address, &id)) {
+        return NULL;
+    }
+
+    const Name& name = m_label_names[id];
+    if (!name.mapped && type != name.type && std::strcmp(LabelSuffix(type), LabelSuffix(name.type)) != 0) {
+        return NULL;
+    }
+    *length = name.length;
+    return m_names.data() + name.offset;
+}
+
+/* Reads the switch table entry at address and returns its size. */
+size_t Snapshot::SwitchEntryAt(const ImageObject& obj, uint32_t address, uint32_t* target) {
+    if (obj.GetBitness() == BITNESS_16BIT) {
+        *target = ReadLe<uint16_t>(obj.GetDataAt(address));
+        return sizeof(uint16_t);
+    }
+    *target = ReadLe<uint32_t>(obj.GetDataAt(address));
+    return sizeof(uint32_t);
+}
+
+void Snapshot::AddLateLabel(uint32_t address, Type type, uint64_t position) {
+    if (!m_labels.Contains(address)) {
+        m_labels.Set(address, type);
+        m_late_labels.push_back(std::make_pair(address, position));
+    }
+}
+
+/* Switch tables used to add labels for their entries while being printed, so output before a table did not see
+ * them. The labels are added here instead, each with the output position the table would have added it at, and
+ * LabelAt() hides them before that position.
+ */
+void Snapshot::AddSwitchLabels(const Image& image) {
+    for (size_t n = 0; n < m_regions.size(); ++n) {
+        const Region& reg = m_regions[n];
+        if (reg.GetType() != SWITCH) {
+            continue;
+        }
+
+        const ImageObject& obj = *reg.ImageObjectPointer();
+        uint32_t func_addr, addr = reg.Address();
+        AddLateLabel(addr, UNKNOWN, OutputPosition(addr, false));
+        while (addr < reg.EndAddress()) {
+            size_t size = SwitchEntryAt(obj, addr, &func_addr);
+            if (image.IsValidAddress(func_addr)) {
+                AddLateLabel(func_addr, addr < func_addr ? CASE : UNKNOWN, OutputPosition(addr, true));
+            }
+            addr += size;
+        }
+    }
+
+    std::sort(m_late_labels.begin(), m_late_labels.end());
+}
+
+/* Spells every label once, so printing a reference only copies its name. */
+void Snapshot::AddLabelNames(SymbolMap* map) {
+    m_labels.AssignIds();
+    m_label_names.resize(m_labels.Size());
+    m_names.reserve(m_labels.Size() * 16);
+
+    for (LabelMap::const_iterator itr = m_labels.begin(); itr != m_labels.end(); ++itr) {
+        size_t id;
+        m_labels.Id(itr->first, &id);
+        Name& name = m_label_names[id];
+        name.offset = m_names.size();
+
+        const SymbolMapProperties* item = map ? map->GetMapItem(itr->first) : NULL;
+        if (item) {
+            m_names += item->name;
+        } else {
+            AppendGeneratedName(m_names, itr->first, itr->second);
+        }
+        name.length = m_names.size() - name.offset;
+        name.type = itr->second;
+        name.mapped = item != NULL;
+    }
+}
@@ -0,0 +1,88 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LE_DISASM_SNAPSHOT_HPP_
+#define LE_DISASM_SNAPSHOT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fixup_index.hpp"
+#include "label_map.hpp"
+#include "region.hpp"
+#include "type.hpp"
+
+class Image;
+class ImageObject;
+class Regions;
+class SymbolMap;
+
+/* Immutable result of the analysis that emission and queries read from. Freezing copies the regions into a sorted
+ * array, takes the labels and the relocation targets over from the analysis without copying them, and resolves the
+ * labels of switch table entries that used to be added while the tables were printed. The final spelling of every
+ * label is computed once into a string arena as well.
+ * Nothing changes after construction, so any number of threads may read a snapshot without locking and it can be
+ * printed as often as needed.
+ */
+class Snapshot {
+public:
+    Snapshot(const Image& image, Regions& regions, SortedKeys& fixup_addresses, SymbolMap* map);
+
+    const std::vector<Region>& GetRegions() const;
+    const LabelMap& GetLabels() const;
+    const Region* RegionContaining(uint32_t address) const;
+    const Region* NextRegion(const Region& reg) const;
+    bool IsFixupAddress(uint32_t address) const;
+
+    static uint64_t OutputPosition(uint32_t address, bool after);
+    bool LabelAt(uint32_t address, uint64_t position, Type* type) const;
+    bool NextLabel(uint32_t address, uint64_t position, uint32_t* next) const;
+    const char* LabelName(uint32_t address, Type type, size_t* length) const;
+
+    static size_t SwitchEntryAt(const ImageObject& obj, uint32_t address, uint32_t* target);
+
+private:
+    class Name {
+    public:
+        uint32_t offset;
+        uint32_t length;
+        /* Generated names end in the suffix of this type, names from the symbol map are used for any type. */
+        Type type;
+        bool mapped;
+    };
+
+    /* Sorted by address. */
+    std::vector<Region> m_regions;
+    LabelMap m_labels;
+    /* Switch table labels and the output position from which on each is printed, sorted by address. */
+    std::vector<std::pair<uint32_t, uint64_t> > m_late_labels;
+    SortedKeys m_fixup_addresses;
+    /* Label names by label id, each is a slice of m_names. */
+    std::string m_names;
+    std::vector<Name> m_label_names;
+
+    void AddSwitchLabels(const Image& image);
+    void AddLateLabel(uint32_t address, Type type, uint64_t position);
+    void AddLabelNames(SymbolMap* map);
+
+    Snapshot(const Snapshot&);
+    Snapshot& operator=(const Snapshot&);
+};
+
+#endif
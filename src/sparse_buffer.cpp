@@ -0,0 +1,65 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sparse_buffer.hpp"
+
+#if defined(WINDOWS_BUILD)
+#include <windows.h>
+#elif defined(UNIX_BUILD)
+#include <sys/mman.h>
+#endif
+
+SparseBuffer::SparseBuffer() : m_data(NULL), m_size(0) {}
+
+SparseBuffer::~SparseBuffer() { Release(); }
+
+bool SparseBuffer::Allocate(size_t size) {
+    Release();
+    void* data = NULL;
+    if (size == 0) {
+        return false;
+    }
+#if defined(WINDOWS_BUILD)
+    data = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#elif defined(UNIX_BUILD)
+    data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+        data = NULL;
+    }
+#endif
+    if (!data) {
+        return false;
+    }
+    m_data = (uint8_t*)data;
+    m_size = size;
+    return true;
+}
+
+void SparseBuffer::Release() {
+    if (m_data) {
+#if defined(WINDOWS_BUILD)
+        VirtualFree(m_data, 0, MEM_RELEASE);
+#elif defined(UNIX_BUILD)
+        munmap(m_data, m_size);
+#endif
+    }
+    m_data = NULL;
+    m_size = 0;
+}
+
+uint8_t* SparseBuffer::Data() const { return m_data; }
+
+size_t SparseBuffer::Size() const { return m_size; }
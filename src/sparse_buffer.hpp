@@ -0,0 +1,45 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LE_DISASM_SPARSE_BUFFER_HPP_
+#define LE_DISASM_SPARSE_BUFFER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+/* Zero initialized anonymous memory. The operating system backs every page with a shared zero page until it is
+ * first written, so large mostly empty objects only cost memory for the pages that are actually loaded.
+ */
+class SparseBuffer {
+public:
+    SparseBuffer();
+    ~SparseBuffer();
+
+    bool Allocate(size_t size);
+    uint8_t* Data() const;
+    size_t Size() const;
+
+private:
+    uint8_t* m_data;
+    size_t m_size;
+
+    SparseBuffer(const SparseBuffer&);
+    SparseBuffer& operator=(const SparseBuffer&);
+
+    void Release();
+};
+
+#endif
@@ -0,0 +1,344 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "x86_decoder.hpp"
+
+#include "insn.hpp"
+#include "little_endian.hpp"
+
+#define M MODRM
+#define Ib IMM8
+#define Iw IMM16
+#define Iz IMMZ
+#define Ia MOFFS
+#define Ap FAR
+#define Jb REL8
+#define Jz RELZ
+#define G GROUP
+#define Gb (MODRM | IMM8 | GROUP)
+#define Gz (MODRM | IMMZ | GROUP)
+#define F (FPU | MODRM)
+#define P PREFIX
+#define E ESCAPE
+#define X UNSUPPORTED
+
+// clang-format off
+const uint16_t X86Decoder::s_one_byte[256] = {
+/*      0      1      2      3      4      5      6      7      8      9      a      b      c      d      e      f */
+/*0*/ M,     M,     M,     M,     Ib,    Iz,    0,     0,     M,     M,     M,     M,     Ib,    Iz,    0,     E,
+/*1*/ M,     M,     M,     M,     Ib,    Iz,    0,     0,     M,     M,     M,     M,     Ib,    Iz,    0,     0,
+/*2*/ M,     M,     M,     M,     Ib,    Iz,    P,     0,     M,     M,     M,     M,     Ib,    Iz,    P,     0,
+/*3*/ M,     M,     M,     M,     Ib,    Iz,    P,     0,     M,     M,     M,     M,     Ib,    Iz,    P,     0,
+/*4*/ 0,     0,     0,     0,     0,     0,     0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+/*5*/ 0,     0,     0,     0,     0,     0,     0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+/*6*/ 0,     0,     M|G,   M,     P,     P,     P,     P,     Iz,    M|Iz,  Ib,    M|Ib,  0,     0,     0,     0,
+/*7*/ Jb,    Jb,    Jb,    Jb,    Jb,    Jb,    Jb,    Jb,    Jb,    Jb,    Jb,    Jb,    Jb,    Jb,    Jb,    Jb,
+/*8*/ M|Ib,  M|Iz,  M|Ib,  M|Ib,  M,     M,     M,     M,     M,     M,     M,     M,     M|G,   M|G,   M|G,   M|G,
+/*9*/ 0,     0,     0,     0,     0,     0,     0,     0,     0,     0,     Ap,    X,     0,     0,     0,     0,
+/*a*/ Ia,    Ia,    Ia,    Ia,    0,     0,     0,     0,     Ib,    Iz,    0,     0,     0,     0,     0,     0,
+/*b*/ Ib,    Ib,    Ib,    Ib,    Ib,    Ib,    Ib,    Ib,    Iz,    Iz,    Iz,    Iz,    Iz,    Iz,    Iz,    Iz,
+/*c*/ M|Ib,  M|Ib,  Iw,    0,     M|G,   M|G,   Gb,    Gz,    Iw|Ib, 0,     Iw,    0,     0,     Ib,    0,     0,
+/*d*/ M,     M,     M,     M,     Ib,    Ib,    X,     0,     F,     F,     F,     F,     F,     F,     F,     F,
+/*e*/ Jb,    Jb,    Jb,    Jb,    Ib,    Ib,    Ib,    Ib,    Jz,    Jz,    Ap,    Jb,    0,     0,     0,     0,
+/*f*/ P,     0,     P,     P,     0,     0,     M|G,   M|G,   0,     0,     0,     0,     0,     0,     M|G,   M|G,
+};
+
+const uint16_t X86Decoder::s_two_byte[256] = {
+/*      0      1      2      3      4      5      6      7      8      9      a      b      c      d      e      f */
+/*0*/ M|G,   M|G,   M,     M,     X,     X,     0,     X,     0,     0,     X,     0,     X,     X,     X,     X,
+/*1*/ X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,
+/*2*/ X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,
+/*3*/ 0,     0,     0,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,
+/*4*/ M,     M,     M,     M,     M,     M,     M,     M,     M,     M,     M,     M,     M,     M,     M,     M,
+/*5*/ X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,
+/*6*/ X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,
+/*7*/ X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,
+/*8*/ Jz,    Jz,    Jz,    Jz,    Jz,    Jz,    Jz,    Jz,    Jz,    Jz,    Jz,    Jz,    Jz,    Jz,    Jz,    Jz,
+/*9*/ M,     M,     M,     M,     M,     M,     M,     M,     M,     M,     M,     M,     M,     M,     M,     M,
+/*a*/ 0,     0,     0,     M,     M|Ib,  M,     X,     X,     0,     0,     X,     M,     M|Ib,  M,     X,     M,
+/*b*/ M,     M,     M|G,   M,     M|G,   M|G,   M,     M,     X,     X,     Gb,    M,     M,     M,     M,     M,
+/*c*/ M,     M,     X,     X,     X,     X,     X,     X,     0,     0,     0,     0,     0,     0,     0,     0,
+/*d*/ X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,
+/*e*/ X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,
+/*f*/ X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,     X,
+};
+// clang-format on
+
+#undef M
+#undef Ib
+#undef Iw
+#undef Iz
+#undef Ia
+#undef Ap
+#undef Jb
+#undef Jz
+#undef G
+#undef Gb
+#undef Gz
+#undef F
+#undef P
+#undef E
+#undef X
+
+/* Decodes the instruction at address into insn the same way DisInfo::Disassemble would, except for the text. Returns
+ * false if the encoding is not supported, insn is left in an undefined state then.
+ */
+bool X86Decoder::Decode(uint32_t address, const void* data, size_t length, Insn& insn) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    const bool code16 = insn.GetBitness() == BITNESS_16BIT;
+    bool operand_prefix = false;
+    bool address_prefix = false;
+    bool rep_prefix = false;
+    size_t pos = 0;
+
+    for (;; ++pos) {
+        if (pos >= length || pos >= MAX_LENGTH) {
+            return false;
+        }
+        if (!(s_one_byte[bytes[pos]] & PREFIX)) {
+            break;
+        }
+        if (bytes[pos] == 0x66 && !operand_prefix) {
+            operand_prefix = true;
+        } else if (bytes[pos] == 0x67 && !address_prefix) {
+            address_prefix = true;
+        } else if ((bytes[pos] == 0xf2 || bytes[pos] == 0xf3) && !rep_prefix) {
+            rep_prefix = true;
+        } else {
+            /* Segment overrides, lock and repeated prefixes are rendered as part of the text by libopcodes. */
+            return false;
+        }
+    }
+
+    const size_t prefix_count = pos;
+    bool two_byte = false;
+    uint8_t opcode = bytes[pos++];
+    unsigned operands = s_one_byte[opcode];
+
+    if (operands & ESCAPE) {
+        if (pos >= length) {
+            return false;
+        }
+        two_byte = true;
+        opcode = bytes[pos++];
+        operands = s_two_byte[opcode];
+    }
+
+    if (operands & UNSUPPORTED) {
+        return false;
+    }
+    if (rep_prefix && (two_byte || !IsStringOperation(opcode))) {
+        return false;
+    }
+    if (!two_byte && opcode == 0x90 && prefix_count > 0) {
+        /* pause, xchg and prefixed nop variants */
+        return false;
+    }
+
+    const bool operand16 = code16 != operand_prefix;
+    const bool address16 = code16 != address_prefix;
+    uint8_t modrm = 0;
+
+    if (operands & MODRM) {
+        if (pos >= length) {
+            return false;
+        }
+        modrm = bytes[pos];
+        if ((operands & FPU) && (operand_prefix || address_prefix)) {
+            /* libopcodes prints these prefixes in front of the mnemonic */
+            return false;
+        }
+        if ((operands & (GROUP | FPU)) && !CheckGroup(two_byte, opcode, modrm, operands)) {
+            return false;
+        }
+        size_t modrm_size = ModRmSize(&bytes[pos], length - pos, address16);
+        if (modrm_size == 0) {
+            return false;
+        }
+        pos += modrm_size;
+    }
+
+    const size_t immediate_offset = pos;
+    if (operands & IMM16) {
+        pos += 2;
+    }
+    if (operands & (IMM8 | REL8)) {
+        pos += 1;
+    }
+    if (operands & (IMMZ | RELZ)) {
+        pos += operand16 ? 2 : 4;
+    }
+    if (operands & MOFFS) {
+        pos += address16 ? 2 : 4;
+    }
+    if (operands & FAR) {
+        pos += operand16 ? 4 : 6;
+    }
+    if (pos > length || pos > MAX_LENGTH) {
+        return false;
+    }
+
+    /* Branch targets are computed like libopcodes does, 16 bit displacements wrap around within the 64 KiB segment of
+     * the next instruction in 16 bit code and are truncated to 16 bits in 32 bit code.
+     */
+    uint32_t next = address + pos;
+    uint32_t target = 0;
+    if (operands & REL8) {
+        target = next + ReadLe<int8_t>(&bytes[pos - 1]);
+    } else if ((operands & RELZ) && !operand16) {
+        target = next + ReadLe<int32_t>(&bytes[pos - 4]);
+    } else if ((operands & RELZ) && code16) {
+        target = (next & ~0xffffu) | ((next + ReadLe<int16_t>(&bytes[pos - 2])) & 0xffffu);
+    } else if (operands & RELZ) {
+        target = (next + ReadLe<int16_t>(&bytes[pos - 2])) & 0xffffu;
+    }
+
+    insn.Assign(Insn::MISC, "", 0, target, address, pos, NULL, 0);
+    insn.SetTargetAndType(address, data);
+
+    const unsigned reg = (modrm >> 3) & 7;
+    if (operands & FPU) {
+        /* Memory forms libopcodes prints with a t or l suffix, one bit per reg field. */
+        static const uint8_t s_m80_forms[8] = {0x00, 0x00, 0x00, 0xa0, 0x00, 0x00, 0x00, 0x00};
+        static const uint8_t s_m64_forms[8] = {0x00, 0x00, 0xff, 0x0f, 0xff, 0x0f, 0x00, 0xa0};
+        insn.flags |= Insn::FPU;
+        if (s_m80_forms[opcode - 0xd8] & (1 << reg)) {
+            insn.flags |= Insn::FPU_M80;
+        } else if (s_m64_forms[opcode - 0xd8] & (1 << reg)) {
+            insn.flags |= Insn::FPU_M64;
+        }
+    } else if (!two_byte && opcode == 0xff && reg >= 2 && reg < 6) {
+        /* call and jmp through a register or memory operand */
+        insn.flags |= Insn::INDIRECT;
+    } else if (!two_byte && opcode == 0x90) {
+        insn.flags |= Insn::NOP;
+    } else if (!two_byte && !address_prefix) {
+        /* mov $imm, %reg, the prefix is only consumed by word and dword sized moves */
+        bool byte_move = (opcode >= 0xb0 && opcode < 0xb8) || (opcode == 0xc6 && (modrm >> 6) == 3);
+        bool word_move = (opcode >= 0xb8 && opcode < 0xc0) || (opcode == 0xc7 && (modrm >> 6) == 3);
+        if (byte_move && !operand_prefix) {
+            insn.flags |= Insn::MOV_IMMEDIATE;
+            insn.immediate = bytes[immediate_offset];
+        } else if (word_move) {
+            insn.flags |= Insn::MOV_IMMEDIATE;
+            insn.immediate =
+                operand16 ? ReadLe<uint16_t>(&bytes[immediate_offset]) : ReadLe<uint32_t>(&bytes[immediate_offset]);
+        }
+    }
+
+    return true;
+}
+
+/* Rejects group members that are invalid or decoded differently by libopcodes and adds operands that depend on the
+ * ModRM byte.
+ */
+bool X86Decoder::CheckGroup(bool two_byte, uint8_t opcode, uint8_t modrm, unsigned& operands) {
+    const unsigned mod = modrm >> 6;
+    const unsigned reg = (modrm >> 3) & 7;
+
+    if (two_byte) {
+        switch (opcode) {
+            case 0x00:
+                return reg < 6;
+            case 0x01:
+                return mod != 3 && reg != 5;
+            case 0xb2:
+            case 0xb4:
+            case 0xb5:
+                return mod != 3;
+            case 0xba:
+                return reg >= 4;
+        }
+        return false;
+    }
+
+    if (operands & FPU) {
+        /* Register forms are left to libopcodes, the memory forms are all valid except for four reserved slots. */
+        static const uint8_t s_invalid_memory_forms[8] = {0x00, 0x02, 0x00, 0x50, 0x00, 0x20, 0x00, 0x00};
+        return mod != 3 && !(s_invalid_memory_forms[opcode - 0xd8] & (1 << reg));
+    }
+
+    switch (opcode) {
+        case 0x62:
+        case 0x8d:
+        case 0xc4:
+        case 0xc5:
+            /* bound, lea, les and lds need a memory operand, VEX and EVEX prefixes share the register forms */
+            return mod != 3;
+        case 0x8c:
+        case 0x8e:
+            return reg < 6;
+        case 0x8f:
+        case 0xc6:
+        case 0xc7:
+            return reg == 0;
+        case 0xf6:
+            if (reg < 2) {
+                operands |= IMM8;
+            }
+            return true;
+        case 0xf7:
+            if (reg < 2) {
+                operands |= IMMZ;
+            }
+            return true;
+        case 0xfe:
+            return reg < 2;
+        case 0xff:
+            return reg != 7 && !(mod == 3 && (reg == 3 || reg == 5));
+    }
+    return false;
+}
+
+/* Returns the size of the ModRM byte, the SIB byte and the displacement or zero if they do not fit into length. */
+size_t X86Decoder::ModRmSize(const uint8_t* data, size_t length, bool address16) {
+    const unsigned mod = data[0] >> 6;
+    const unsigned rm = data[0] & 7;
+    size_t size = 1;
+
+    if (mod == 3) {
+        return size;
+    }
+
+    if (address16) {
+        if (mod == 1) {
+            size += 1;
+        } else if (mod == 2 || rm == 6) {
+            size += 2;
+        }
+    } else {
+        if (rm == 4) {
+            if (length < 2) {
+                return 0;
+            }
+            if (mod == 0 && (data[1] & 7) == 5) {
+                size += 4;
+            }
+            size += 1;
+        }
+        if (mod == 1) {
+            size += 1;
+        } else if (mod == 2 || rm == 5) {
+            size += 4;
+        }
+    }
+
+    return size <= length ? size : 0;
+}
+
+bool X86Decoder::IsStringOperation(uint8_t opcode) {
+    return (opcode >= 0x6c && opcode < 0x70) || (opcode >= 0xa4 && opcode < 0xa8) || (opcode >= 0xaa && opcode < 0xb0);
+}
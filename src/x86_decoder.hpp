@@ -0,0 +1,65 @@
+/* Copyright (C) 2025  klei1984 <53688147+klei1984@users.noreply.github.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LE_DISASM_X86_DECODER_HPP_
+#define LE_DISASM_X86_DECODER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+class Insn;
+
+/* Table driven x86 instruction length and control flow decoder for 16 and 32 bit code. It produces everything the
+ * tracing pass needs (size, branch type and target, invalid, nop and immediate mov classification) without formatting
+ * any text. Encodings whose libopcodes rendering it cannot reproduce exactly, like segment overrides, lock prefixes,
+ * fwait sequences or most 0x0f opcodes, are rejected and left to libopcodes.
+ */
+class X86Decoder {
+public:
+    static bool Decode(uint32_t address, const void* data, size_t length, Insn& insn);
+
+private:
+    enum { MAX_LENGTH = 15 };
+
+    enum Operands {
+        MODRM = 0x0001,
+        IMM8 = 0x0002,
+        IMM16 = 0x0004,
+        /* 16 or 32 bit immediate depending on the operand size. */
+        IMMZ = 0x0008,
+        /* Absolute memory offset sized by the address size. */
+        MOFFS = 0x0010,
+        /* Far pointer, a 16 bit selector following a 16 or 32 bit offset. */
+        FAR = 0x0020,
+        REL8 = 0x0040,
+        RELZ = 0x0080,
+        /* Opcode depends on the ModRM reg field or mod, checked by CheckGroup. */
+        GROUP = 0x0100,
+        FPU = 0x0200,
+        PREFIX = 0x0400,
+        ESCAPE = 0x0800,
+        UNSUPPORTED = 0x1000
+    };
+
+    static const uint16_t s_one_byte[256];
+    static const uint16_t s_two_byte[256];
+
+    static bool CheckGroup(bool two_byte, uint8_t opcode, uint8_t modrm, unsigned& operands);
+    static size_t ModRmSize(const uint8_t* data, size_t length, bool address16);
+    static bool IsStringOperation(uint8_t opcode);
+};
+
+#endif